@@ -0,0 +1,270 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "executive/concurrent.h"
+#include "executive-private.h"
+
+/*
+  Each heap is a binary min-heap of Event pointers, guarded by its
+  lock.  'top' caches the heap's earliest time, as µs since the epoch
+  (EMPTY if none), so that heaps can be compared without locking
+  them.  Heaps are cache-line aligned, lest threads working different
+  heaps share lines.
+*/
+#define EMPTY INT64_MAX
+
+typedef struct Heap {
+  _Alignas( 64 ) pthread_mutex_t lock;
+  _Atomic int64_t top;
+  Event** events;
+  size_t length;
+  size_t capacity;
+} Heap;
+
+struct ConcurrentExecutive {
+  Heap* heaps;
+  size_t heapsLength;
+  _Atomic size_t length;
+};
+
+// Heaps per thread, more means less contention, looser ordering
+#define HEAPS_PER_THREAD 2
+
+// Fire tries this many random pairs before searching every heap
+#define FIRE_ATTEMPTS 4
+
+static int64_t micros( struct timeval* tv );
+static size_t randomHeap( ConcurrentExecutive* thiz );
+static int heapPush( Heap* h, Event* e );
+static Event* heapPop( Heap* h );
+static bool heapTryFire( Heap* h, int64_t now, bool wait, Event** result );
+
+ConcurrentExecutive* executiveConcurrentNew( size_t threads ) {
+  ConcurrentExecutive* result = malloc( sizeof( ConcurrentExecutive ) );
+  if( !result )
+	return NULL;
+  result->heapsLength = HEAPS_PER_THREAD * (threads ? threads : 1);
+  result->heaps = aligned_alloc( _Alignof( Heap ),
+								 result->heapsLength * sizeof( Heap ) );
+  if( !result->heaps ) {
+	free( result );
+	return NULL;
+  }
+  for( size_t i = 0; i < result->heapsLength; i++ ) {
+	Heap* h = &result->heaps[i];
+	pthread_mutex_init( &h->lock, NULL );
+	atomic_init( &h->top, EMPTY );
+	h->events = NULL;
+	h->length = h->capacity = 0;
+  }
+  atomic_init( &result->length, 0 );
+  return result;
+}
+
+void executiveConcurrentFree( ConcurrentExecutive* thiz ) {
+  for( size_t i = 0; i < thiz->heapsLength; i++ ) {
+	Heap* h = &thiz->heaps[i];
+	for( size_t j = 0; j < h->length; j++ )
+	  free( h->events[j] );
+	free( h->events );
+	pthread_mutex_destroy( &h->lock );
+  }
+  free( thiz->heaps );
+  free( thiz );
+}
+
+int executiveConcurrentAdd( ConcurrentExecutive* thiz,
+							struct timeval* scheduledTime,
+							Action action, void* env ) {
+  Event* e = malloc( sizeof( Event ) );
+  if( !e )
+	return -1;
+  *e = (Event){ .scheduledTime = *scheduledTime, .action = action,
+				.env = env };
+
+  // any uncontended heap will do, else wait for one
+  Heap* h = NULL;
+  for( int i = 0; i < FIRE_ATTEMPTS && !h; i++ ) {
+	h = &thiz->heaps[randomHeap( thiz )];
+	if( pthread_mutex_trylock( &h->lock ) )
+	  h = NULL;
+  }
+  if( !h ) {
+	h = &thiz->heaps[randomHeap( thiz )];
+	pthread_mutex_lock( &h->lock );
+  }
+  int sc = heapPush( h, e );
+  pthread_mutex_unlock( &h->lock );
+  if( sc ) {
+	free( e );
+	return -1;
+  }
+  atomic_fetch_add( &thiz->length, 1 );
+  return 0;
+}
+
+bool executiveConcurrentPeek( ConcurrentExecutive* thiz,
+							  struct timeval* result ) {
+  int64_t min = EMPTY;
+  for( size_t i = 0; i < thiz->heapsLength; i++ ) {
+	int64_t top = atomic_load( &thiz->heaps[i].top );
+	if( top < min )
+	  min = top;
+  }
+  if( min == EMPTY )
+	return false;
+  result->tv_sec = min / 1000000;
+  result->tv_usec = min % 1000000;
+  return true;
+}
+
+bool executiveConcurrentFire( ConcurrentExecutive* thiz,
+							  struct timeval* now ) {
+  int64_t t = micros( now );
+  Event* e = NULL;
+
+  // the earlier of two random heaps, usually uncontended
+  for( int i = 0; i < FIRE_ATTEMPTS && !e; i++ ) {
+	Heap* a = &thiz->heaps[randomHeap( thiz )];
+	Heap* b = &thiz->heaps[randomHeap( thiz )];
+	Heap* h = atomic_load( &a->top ) <= atomic_load( &b->top ) ? a : b;
+	if( atomic_load( &h->top ) > t )
+	  continue;
+	heapTryFire( h, t, false, &e );
+  }
+
+  // else, before giving up, every heap, locking if need be
+  for( size_t i = 0; i < thiz->heapsLength && !e; i++ )
+	heapTryFire( &thiz->heaps[i], t, true, &e );
+  if( !e )
+	return false;
+
+  atomic_fetch_sub( &thiz->length, 1 );
+  if( e->action )
+	(e->action)( e, now );
+  free( e );
+  return true;
+}
+
+size_t executiveConcurrentLength( ConcurrentExecutive* thiz ) {
+  return atomic_load( &thiz->length );
+}
+
+/******************************* STATICS **********************************/
+
+static int64_t micros( struct timeval* tv ) {
+  return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+// xorshift64, one generator per thread, so no shared state
+static size_t randomHeap( ConcurrentExecutive* thiz ) {
+  static _Thread_local uint64_t state;
+  if( !state )
+	state = (uint64_t)(uintptr_t)&state | 1;
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return (size_t)(state % thiz->heapsLength);
+}
+
+/*
+  Pop h's head into *result if due by 'now'.  Without 'wait', gives up
+  rather than block on the lock.
+*/
+static bool heapTryFire( Heap* h, int64_t now, bool wait, Event** result ) {
+  if( atomic_load( &h->top ) > now )
+	return false;
+  if( wait )
+	pthread_mutex_lock( &h->lock );
+  else if( pthread_mutex_trylock( &h->lock ) )
+	return false;
+  // the top may have gone meanwhile
+  if( h->length && micros( &h->events[0]->scheduledTime ) <= now )
+	*result = heapPop( h );
+  pthread_mutex_unlock( &h->lock );
+  return *result != NULL;
+}
+
+static bool eventBefore( Event* a, Event* b ) {
+  return timercmp( &a->scheduledTime, &b->scheduledTime, < );
+}
+
+static int heapPush( Heap* h, Event* e ) {
+  if( h->length == h->capacity ) {
+	size_t capacity = h->capacity ? 2 * h->capacity : 64;
+	Event** events = realloc( h->events, capacity * sizeof( Event* ) );
+	if( !events )
+	  return -1;
+	h->events = events;
+	h->capacity = capacity;
+  }
+  size_t i = h->length++;
+  while( i > 0 && eventBefore( e, h->events[(i - 1) / 2] ) ) {
+	h->events[i] = h->events[(i - 1) / 2];
+	i = (i - 1) / 2;
+  }
+  h->events[i] = e;
+  atomic_store( &h->top, micros( &h->events[0]->scheduledTime ) );
+  return 0;
+}
+
+static Event* heapPop( Heap* h ) {
+  Event* result = h->events[0];
+  Event* last = h->events[--h->length];
+  size_t i = 0;
+  while( true ) {
+	size_t least = 2 * i + 1;
+	if( least >= h->length )
+	  break;
+	if( least + 1 < h->length &&
+		eventBefore( h->events[least + 1], h->events[least] ) )
+	  least++;
+	if( !eventBefore( h->events[least], last ) )
+	  break;
+	h->events[i] = h->events[least];
+	i = least;
+  }
+  if( h->length )
+	h->events[i] = last;
+  atomic_store( &h->top, h->length ?
+				micros( &h->events[0]->scheduledTime ) : EMPTY );
+  return result;
+}
+
+// eof
@@ -0,0 +1,325 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "executive/debounce.h"
+#include "executive-private.h"
+
+/*
+  One per key, in a chained hash table.  The key's one pending Event
+  is in 'storage', with the entry as its env and envFree, so the entry
+  is free'd with the Event should the Executive be cleared or freed.
+  A debounced entry's Event may be early, 'due' having moved on since
+  it was armed, in which case it just re-arms.
+*/
+typedef struct DebounceEntry {
+  struct DebounceEntry* next;
+  struct DebounceTable* table;
+  void* key;
+
+  bool throttle;
+  struct timeval period;
+  struct timeval due;
+  bool triggered;
+
+  Action action;
+  void* env;
+  bool firing;
+  bool cancelled;
+  ExecutiveEventStorage storage;
+} DebounceEntry;
+
+typedef struct DebounceTable {
+  DebounceEntry** buckets;
+  size_t capacity;
+  size_t length;
+} DebounceTable;
+
+static DebounceEntry* debounceEntry( Executive* e, void* key, bool* created );
+static DebounceTable* debounceTable( Executive* e );
+static DebounceEntry** debounceFind( DebounceTable* t, void* key );
+static int debounceLink( DebounceTable* t, DebounceEntry* entry );
+static int debounceGrow( DebounceTable* t );
+static void debounceUnlink( DebounceEntry* entry );
+static int debounceArm( Executive* e, DebounceEntry* entry,
+						struct timeval* at );
+static void debounceAction( Event* e, struct timeval* actualTime );
+static void debounceCall( DebounceEntry* entry, Event* e,
+						  struct timeval* actualTime );
+static void debounceFree( void* env );
+static size_t keyHash( void* key, size_t capacity );
+
+int executiveDebounce( Executive* thiz, void* key, struct timeval* now,
+					   struct timeval* delay, Action action, void* env ) {
+  bool created;
+  DebounceEntry* entry = debounceEntry( thiz, key, &created );
+  if( !entry )
+	return -1;
+  entry->throttle = false;
+  entry->period = *delay;
+  timeradd( now, delay, &entry->due );
+  entry->action = action;
+  entry->env = env;
+  if( created && debounceArm( thiz, entry, &entry->due ) ) {
+	debounceFree( entry );
+	return -1;
+  }
+  return 0;
+}
+
+int executiveThrottle( Executive* thiz, void* key, struct timeval* now,
+					   struct timeval* interval, Action action, void* env ) {
+  bool created;
+  DebounceEntry* entry = debounceEntry( thiz, key, &created );
+  if( !entry )
+	return -1;
+  entry->throttle = true;
+  entry->period = *interval;
+  entry->triggered = true;
+  entry->action = action;
+  entry->env = env;
+  if( created && debounceArm( thiz, entry, now ) ) {
+	debounceFree( entry );
+	return -1;
+  }
+  return 0;
+}
+
+int executiveDebounceCancel( Executive* thiz, void* key ) {
+  DebounceTable* t = thiz->debounces;
+  DebounceEntry** ep = t ? debounceFind( t, key ) : NULL;
+  if( !ep || !*ep )
+	return -1;
+  DebounceEntry* entry = *ep;
+  debounceUnlink( entry );
+  // mid-action, our Event is not pending, debounceAction frees us
+  if( entry->firing )
+	entry->cancelled = true;
+  else
+	executiveEventCancel( (Event*)&entry->storage );
+  return 0;
+}
+
+/*
+  A key's Event has moved to dst (executiveMigrate), so its entry
+  moves to dst's table.  Should dst have that key already, or no
+  memory, the entry is left unlinked: its pending call is still made,
+  but it takes no more triggers.
+*/
+void executiveDebounceAdopt( Executive* dst, Event* e ) {
+  if( e->action != debounceAction )
+	return;
+  DebounceEntry* entry = (DebounceEntry*)e->env;
+  debounceUnlink( entry );
+  DebounceTable* t = debounceTable( dst );
+  if( !t )
+	return;
+  DebounceEntry** ep = t->capacity ? debounceFind( t, entry->key ) : NULL;
+  if( !(ep && *ep) )
+	debounceLink( t, entry );
+}
+
+// Any entries went with their Events, when the Executive was cleared
+void executiveDebounceFree( Executive* thiz ) {
+  DebounceTable* t = thiz->debounces;
+  if( !t )
+	return;
+  free( t->buckets );
+  free( t );
+  thiz->debounces = NULL;
+}
+
+/******************************* STATICS **********************************/
+
+/*
+  The key's entry, else a new one, linked in but with no Event yet.
+  The caller arms it, which failing, it is free'd.
+*/
+static DebounceEntry* debounceEntry( Executive* e, void* key, bool* created ) {
+  DebounceTable* t = debounceTable( e );
+  if( !t )
+	return NULL;
+  DebounceEntry** ep = t->capacity ? debounceFind( t, key ) : NULL;
+  if( ep && *ep ) {
+	*created = false;
+	return *ep;
+  }
+
+  DebounceEntry* result = malloc( sizeof( DebounceEntry ) );
+  if( !result )
+	return NULL;
+  result->key = key;
+  result->triggered = false;
+  result->firing = result->cancelled = false;
+  if( debounceLink( t, result ) ) {
+	free( result );
+	return NULL;
+  }
+  *created = true;
+  return result;
+}
+
+// e's key table, created on first use
+static DebounceTable* debounceTable( Executive* e ) {
+  if( !e->debounces )
+	e->debounces = calloc( 1, sizeof( DebounceTable ) );
+  return e->debounces;
+}
+
+// Where key's entry is, or would be linked, in its chain
+static DebounceEntry** debounceFind( DebounceTable* t, void* key ) {
+  DebounceEntry** ep = &t->buckets[keyHash( key, t->capacity )];
+  while( *ep && (*ep)->key != key )
+	ep = &(*ep)->next;
+  return ep;
+}
+
+// entry's key not yet in t
+static int debounceLink( DebounceTable* t, DebounceEntry* entry ) {
+  if( t->length >= t->capacity && debounceGrow( t ) )
+	return -1;
+  size_t i = keyHash( entry->key, t->capacity );
+  entry->next = t->buckets[i];
+  t->buckets[i] = entry;
+  t->length++;
+  entry->table = t;
+  return 0;
+}
+
+static int debounceGrow( DebounceTable* t ) {
+  size_t capacity = t->capacity ? 2 * t->capacity : 16;
+  DebounceEntry** buckets = calloc( capacity, sizeof( DebounceEntry* ) );
+  if( !buckets )
+	return -1;
+  for( size_t i = 0; i < t->capacity; i++ ) {
+	while( t->buckets[i] ) {
+	  DebounceEntry* entry = t->buckets[i];
+	  t->buckets[i] = entry->next;
+	  size_t j = keyHash( entry->key, capacity );
+	  entry->next = buckets[j];
+	  buckets[j] = entry;
+	}
+  }
+  free( t->buckets );
+  t->buckets = buckets;
+  t->capacity = capacity;
+  return 0;
+}
+
+// Idempotent, table NULL once unlinked
+static void debounceUnlink( DebounceEntry* entry ) {
+  DebounceTable* t = entry->table;
+  if( !t )
+	return;
+  DebounceEntry** ep = debounceFind( t, entry->key );
+  *ep = entry->next;
+  t->length--;
+  entry->table = NULL;
+}
+
+// On failure, the entry is the caller's to see to
+static int debounceArm( Executive* e, DebounceEntry* entry,
+						struct timeval* at ) {
+  if( executiveAddWithStorage( e, &entry->storage, at,
+							   debounceAction, entry ) == EXECUTIVE_FULL )
+	return -1;
+  ((Event*)&entry->storage)->envFree = debounceFree;
+  return 0;
+}
+
+/*
+  A debounced key: if triggered since we were armed, wait on, else
+  make the call, and forget the key.  A throttled key: if triggered
+  since the last call, make another, then wait out the interval, else
+  forget the key.  Should the Executive be too full to wait on, a
+  debounced key's call is made at once, and a throttled key is
+  forgotten, its next trigger then calling at once.
+*/
+static void debounceAction( Event* e, struct timeval* actualTime ) {
+  DebounceEntry* entry = (DebounceEntry*)e->env;
+  Executive* thiz = e->executive;
+
+  if( !entry->throttle ) {
+	if( timercmp( &e->scheduledTime, &entry->due, < ) &&
+		debounceArm( thiz, entry, &entry->due ) == 0 )
+	  return;
+	// so a trigger from within the call starts afresh
+	debounceUnlink( entry );
+	debounceCall( entry, e, actualTime );
+	free( entry );
+	return;
+  }
+
+  if( !entry->triggered ) {
+	debounceUnlink( entry );
+	free( entry );
+	return;
+  }
+  entry->triggered = false;
+  debounceCall( entry, e, actualTime );
+  struct timeval next;
+  timeradd( actualTime, &entry->period, &next );
+  if( entry->cancelled )
+	free( entry );
+  else if( debounceArm( thiz, entry, &next ) )
+	debounceFree( entry );
+}
+
+// Via an Event bearing the latest trigger's env
+static void debounceCall( DebounceEntry* entry, Event* e,
+						  struct timeval* actualTime ) {
+  Event call = *e;
+  call.action = entry->action;
+  call.env = entry->env;
+  call.envFree = NULL;
+  entry->firing = true;
+  if( call.action )
+	(call.action)( &call, actualTime );
+  entry->firing = false;
+}
+
+static void debounceFree( void* env ) {
+  DebounceEntry* entry = (DebounceEntry*)env;
+  debounceUnlink( entry );
+  free( entry );
+}
+
+static size_t keyHash( void* key, size_t capacity ) {
+  uint64_t h = (uint64_t)(uintptr_t)key * UINT64_C(0x9E3779B97F4A7C15);
+  return (size_t)(h >> 32) & (capacity - 1);
+}
+
+// eof
@@ -0,0 +1,250 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_PRIVATE_H
+#define _EXECUTIVE_PRIVATE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "executive/executive.h"
+
+/**
+   The Executive and Event internals, shared by the modules making up
+   the library (executive.c, loop.c). NOT for use by library clients,
+   who see only the opaque types of executive.h.
+*/
+
+/*
+  Events are linked, intrusively, into either an EventList or (in the
+  GLib build only) the main GList.  An EventList is a plain
+  doubly-linked list, the links being the prev/next pointers embedded
+  in each Event.  Insertion, and removal of any Event, are then free
+  of allocation.
+*/
+typedef struct EventList {
+  Event* head;
+  Event* tail;
+  size_t length;
+} EventList;
+
+/*
+  The radix heap store, of the EXECUTIVE_RADIX build only, see
+  executive.c.  buckets[0] holds the Events due at time 'last',
+  buckets[i] those whose time (in microseconds) first differs from
+  'last' in bit i-1, and bit i-1 of 'occupied' says whether buckets[i]
+  is non-empty.  Events due before 'last' go, sorted, in 'past'.
+*/
+typedef struct RadixStore {
+  uint64_t last;
+  uint64_t occupied;
+  EventList buckets[65];
+  EventList past;
+} RadixStore;
+
+typedef struct Executive {
+  Event* sentinel;
+
+  // user Events in the store, i.e. excluding the sentinel
+  size_t length;
+
+  ExecutiveTimeoutQueue* timeoutQueues;
+
+  // Static Executives only: the unused Event slots, linked via next
+  bool isStatic;
+  Event* freeEvents;
+
+  // Run loop state, see loop.c. NULL until first needed
+  struct ExecutiveLoop* loop;
+
+  /*
+	Nesting, see executiveAttachChild.  Children are held in a binary
+	min-heap, keyed on each child's headKey, the head time it last
+	reported to us.  childLength counts Events pending in all
+	descendants, so executiveLength need not visit them.
+  */
+  struct Executive* parent;
+  size_t parentIndex;
+  struct timeval headKey;
+  struct Executive** children;
+  size_t childrenLength;
+  size_t childrenCapacity;
+  size_t childLength;
+
+  /*
+	Admission control, see executiveSetLimits. 0 = no limit. 'bytes'
+	is the sum of the 'charge' of our pending Events.
+  */
+  size_t maxEvents;
+  size_t maxBytes;
+  size_t bytes;
+  size_t highWatermark;
+  size_t lowWatermark;
+  void (*watermark)( struct Executive*, bool above, void* arg );
+  void* watermarkArg;
+  bool aboveWatermark;
+
+  /*
+	Held around changes to the Executive while Actions are being fired
+	on worker threads (see parallel.c), so they may add/cancel Events.
+	NULL otherwise, for no locking at all.
+  */
+  pthread_mutex_t* mutex;
+
+  // Debounced/throttled keys, see debounce.c. NULL until first used
+  struct DebounceTable* debounces;
+
+  // Per-Action figures, see profile.c. NULL unless profiling
+  struct ExecutiveProfile* profile;
+
+  /*
+	While watched (see watchdog.c), the Event being fired. 'firing' is
+	a serial number, 0 when none, stored last, so read first.  All
+	four are accessed atomically, the watchdog reading them unlocked.
+  */
+  struct ExecutiveWatchdog* watchdog;
+  uint64_t firing;
+  uint64_t firingSerial;
+  Action firingAction;
+  struct timeval firingScheduled;
+
+  /*
+	The time-ordered 'store' of Events added via executiveAdd and
+	friends.  The sentinel is always its last entry, bar in the radix
+	heap, which holds only user Events.  Last member, as the only one
+	differing between builds, so modules other than executive.c need
+	be compiled just once.
+  */
+#ifdef EXECUTIVE_GLIB
+  struct _GList* events;
+#elif defined(EXECUTIVE_RADIX)
+  RadixStore events;
+#else
+  EventList events;
+#endif
+} Executive;
+
+struct ExecutiveTimeoutQueue {
+  Executive* executive;
+  struct timeval duration;
+  EventList events;
+  ExecutiveTimeoutQueue* next;
+};
+
+struct Event {
+  Executive* executive;
+  struct timeval scheduledTime;
+  Action action;
+  void* env;
+  void (*envFree)( void* );
+
+  // Links in the EventList holding us, if any
+  Event* prev;
+  Event* next;
+
+  // Set only for Events on a timeout queue, else NULL
+  ExecutiveTimeoutQueue* timeoutQueue;
+
+  // The static Executive whose storage holds us, or NULL if malloc'd
+  Executive* pool;
+
+  // Memory supplied by caller, see executiveAddWithStorage, never free'd
+  bool external;
+
+  // Bytes counted against our Executive's maxBytes, 0 once refunded
+  size_t charge;
+
+  // Set if we were allocated as one of a batch, see executiveAddBatch
+  struct EventBlock* block;
+
+  // env storage for executiveAddInline, env then points here
+  union {
+	max_align_t align;
+	unsigned char bytes[EXECUTIVE_INLINE_ENV_SIZE];
+  } inlineEnv;
+};
+
+/*
+  Unlink, and return, the head Event if due by 'by', else NULL.  As
+  executiveFire, bar calling the Action and freeing the Event, which
+  is then the caller's job, via executiveEventFree (but only if not
+  'external').
+*/
+Event* executivePop( Executive* thiz, struct timeval* by );
+
+void executiveEventFree( Event* thiz );
+
+/*
+  Discard a pending Event, wherever it is, as executiveClear would.
+  O(1), bar in the GLib store.
+*/
+void executiveEventCancel( Event* e );
+
+// loop.c: pthread_create, the thread having all signals blocked
+int executiveThreadCreate( pthread_t* thread, void* (*main)( void* ),
+						   void* arg );
+
+// loop.c: release any run loop state of an Executive being freed
+void executiveLoopFree( Executive* thiz );
+
+// debounce.c: move a key's entry along with its Event, migrated to dst
+void executiveDebounceAdopt( Executive* dst, Event* e );
+
+// debounce.c: release the key table of an Executive being freed
+void executiveDebounceFree( Executive* thiz );
+
+// profile.c: call e's Action, timing it
+void executiveProfileCall( Executive* thiz, Event* e,
+						   struct timeval* actualTime );
+
+/*
+  loop.c: I/O buffers of 'size' bytes, recycled via a small pool per
+  Executive.  Get returns NULL if out of memory.
+*/
+void* executiveBufferGet( Executive* thiz, size_t size );
+void executiveBufferPut( Executive* thiz, void* buffer, size_t size );
+
+/*
+  loop.c: head of the list of output queues awaiting a flush, NULL if
+  out of memory.  output.c: flush them all, emptying the list.  The
+  loop does so before each wait.
+*/
+struct ExecutiveOutput** executiveLoopDirty( Executive* thiz );
+void executiveOutputFlushDirty( Executive* thiz );
+
+#endif
+
+// eof
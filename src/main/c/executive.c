@@ -32,110 +32,335 @@
  * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
  * DAMAGE.
  */
+#include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
 
+#ifdef EXECUTIVE_GLIB
 #include <glib.h>
+#endif
 
 #include "executive/executive.h"
+#include "executive/profile.h"
+#include "executive/watchdog.h"
+#include "executive-private.h"
 
-typedef struct Executive {
-  GList* events;
-  Event* sentinel;
-} Executive;
+static void executiveInit( Executive* thiz );
 
-struct Event {
-  Executive* executive;
-  struct timeval scheduledTime;
-  Action action;
-  gpointer env;
-  void (*envFree)( gpointer );
-};
+static void* executiveSlotAlloc( Executive* thiz );
 
 static Event* executiveEventNew( Executive* source,
 								 struct timeval* scheduledTime, 
-								 Action action, gpointer env, 
-								 void (*envFree)( gpointer ) );
+								 Action action, void* env, 
+								 void (*envFree)( void* ) );
 
 static void	executiveEventInit( Event* thiz, Executive* source,
 								struct timeval* scheduledTime, Action a, 
-								gpointer env, void (*envFree)( gpointer ) );
-
-static void executiveEventFree( Event* thiz );
+								void* env, void (*envFree)( void* ) );
 
-static int executiveEventComparator( gconstpointer a, gconstpointer b );
 
 static size_t executiveAddImpl( Executive* thiz,
 								struct timeval* scheduledTime, 
-								Action action, 
-								gpointer env, void (*envFree)(gpointer) );
+								Action action, void* env, size_t envSize,
+								void (*envFree)(void*) );
+
+static Event* executiveHead( Executive* thiz );
+
+static void executiveTimeoutQueueAppend( ExecutiveTimeoutQueue* q, Event* e );
+static ExecutiveTimeoutQueue* executiveTimeoutQueueFind( Executive* thiz,
+														 struct timeval* d );
+
+static void executiveUnlink( Executive* thiz, Event* e );
+
+static void executiveChanged( Executive* thiz, ptrdiff_t delta );
+
+static bool executiveAdmit( Executive* thiz, size_t bytes );
+static void executiveCharge( Executive* thiz, Event* e, size_t envSize );
+static void executiveRefund( Event* e );
+static size_t executiveOwnLength( Executive* thiz );
+
+static bool childHeapLess( Executive* p, size_t i, size_t j );
+static void childHeapSwap( Executive* p, size_t i, size_t j );
+static void childHeapSiftUp( Executive* p, size_t i );
+static void childHeapSiftDown( Executive* p, size_t i );
+
+static size_t executiveClearMatching( Executive* thiz,
+									  bool (*match)( Event*, void* ),
+									  void* arg );
+
+static bool eventMatchesTime( Event* e, void* tv );
+static bool eventMatchesAction( Event* e, void* key );
+static bool eventMatchesEnv( Event* e, void* env );
+static bool eventMatchesActionAndEnv( Event* e, void* key );
+
+static void eventListInit( EventList* l );
+static void eventListInsertAfter( EventList* l, Event* pos, Event* e );
+static void eventListUnlink( EventList* l, Event* e );
+static Event* eventListExtractMatching( EventList* l, Event* end,
+										bool (*match)( Event*, void* ),
+										void* arg, size_t* length );
+static void eventListMerge( EventList* l, Event* chain );
+static size_t eventListClearMatching( EventList* l, Event* end,
+									  bool (*match)( Event*, void* ),
+									  void* arg );
+
+static void storeInit( Executive* thiz );
+static void storeFree( Executive* thiz );
+static Event* storeHead( Executive* thiz );
+static void storeInsert( Executive* thiz, Event* e );
+static void storeMerge( Executive* thiz, Event* chain, size_t length );
+static void storeRemove( Executive* thiz, Event* e );
+static size_t storeClearMatching( Executive* thiz,
+								  bool (*match)( Event*, void* ),
+								  void* arg );
+static Event* storeExtractMatching( Executive* thiz,
+									bool (*match)( Event*, void* ),
+									void* arg, size_t* length );
+
+static size_t executiveAddBatchImpl( Executive* thiz,
+									 const EventSpec* specs, size_t n );
+
+static Event* eventChainSort( Event* chain, size_t length );
+
+static size_t executiveMigrateQueue( ExecutiveTimeoutQueue* q,
+									 Executive* dst,
+									 bool (*pred)( Event*, void* ),
+									 void* ctx );
+static void executiveAdopt( Executive* dst, Event* e );
+
+static Executive* executiveRoot( Executive* thiz );
+static void executiveLock( Executive* thiz );
+static void executiveUnlock( Executive* thiz );
 
 static struct timeval ARMAGEDDON = { .tv_sec = INT_MAX,
 									 .tv_usec = 999999 };
 
+// A static Executive is laid out as: Executive, sentinel, Event slots
+#define STATIC_HEADER_SIZE												\
+  ((sizeof( Executive ) + _Alignof( max_align_t ) - 1) &				\
+   ~(_Alignof( max_align_t ) - 1))
+
+/*
+  What an Event costs its Executive, for maxBytes, bar any env. The
+  GLib store adds a list node per Event.
+*/
+#ifdef EXECUTIVE_GLIB
+#define EVENT_COST (sizeof( Event ) + sizeof( GList ))
+#else
+#define EVENT_COST sizeof( Event )
+#endif
+
+// Events of executiveAddWithStorage live in caller's storage
+_Static_assert( sizeof( Event ) <= sizeof( ExecutiveEventStorage ),
+				"EXECUTIVE_EVENT_SIZE too small" );
+
+// Timeout queues of static Executives live in Event slots
+_Static_assert( sizeof( ExecutiveTimeoutQueue ) <= sizeof( Event ),
+				"timeout queue must fit in an Event slot" );
+
 Executive* executiveNew(void) {
   Executive* result = (Executive*)malloc( sizeof( Executive ) );
   if( !result )
 	return NULL;
+  result->isStatic = false;
+  result->freeEvents = NULL;
   result->sentinel = executiveEventNew( NULL, &ARMAGEDDON, NULL, NULL, NULL );
-  result->events = g_list_insert_sorted( NULL, result->sentinel, 
-										 executiveEventComparator );
+  if( !result->sentinel ) {
+	free( result );
+	return NULL;
+  }
+  executiveInit( result );
+  return result;
+}
+
+size_t executiveStaticSize( size_t capacity ) {
+  return STATIC_HEADER_SIZE + (capacity + 1) * sizeof( Event );
+}
+
+Executive* executiveInitStatic( void* storage, size_t capacity ) {
+  Executive* result = (Executive*)storage;
+  Event* slots = (Event*)((char*)storage + STATIC_HEADER_SIZE);
+  result->isStatic = true;
+  result->freeEvents = NULL;
+  for( size_t i = capacity; i > 0; i-- ) {
+	slots[i].next = result->freeEvents;
+	result->freeEvents = &slots[i];
+  }
+  result->sentinel = &slots[0];
+  executiveEventInit( result->sentinel, NULL, &ARMAGEDDON, NULL, NULL, NULL );
+  executiveInit( result );
   return result;
 }
 
 void executiveFree( Executive* thiz ) {
+  if( thiz->parent )
+	executiveDetachChild( thiz->parent, thiz );
+  while( thiz->childrenLength )
+	executiveDetachChild( thiz, thiz->children[0] );
+  free( thiz->children );
+  thiz->watermark = NULL;
+  executiveClear( thiz );
+  executiveDebounceFree( thiz );
+  executiveProfileStop( thiz );
+  if( thiz->watchdog )
+	executiveWatchdogFree( thiz->watchdog );
+  executiveLoopFree( thiz );
+  storeFree( thiz );
+  // all else of a static Executive lives in the caller's storage
+  if( thiz->isStatic )
+	return;
+  while( thiz->timeoutQueues ) {
+	ExecutiveTimeoutQueue* q = thiz->timeoutQueues;
+	thiz->timeoutQueues = q->next;
+	free( q );
+  }
   executiveEventFree( thiz->sentinel );
-  g_list_free( thiz->events );
   free( thiz );
 }
 
 size_t executiveAdd( Executive* e, 
 					 struct timeval* scheduledTime, Action action ) {
-  return executiveAddImpl( e, scheduledTime, action, NULL, NULL );
+  return executiveAddImpl( e, scheduledTime, action, NULL, 0, NULL );
 }
 
 size_t executiveAddWithEnv( Executive* e, 
 							struct timeval* scheduledTime, Action action,
 							void* env ) {
-  return executiveAddImpl( e, scheduledTime, action, env, NULL );
+  return executiveAddImpl( e, scheduledTime, action, env, 0, NULL );
 }
 
 size_t executiveAddWithFreeFunc( Executive* e,
 								 struct timeval* scheduledTime, 
 								 Action action, 
-								 gpointer env, void (*envFree)(gpointer) ) {
-  return executiveAddImpl( e, scheduledTime, action, env, envFree );
+								 void* env, void (*envFree)(void*) ) {
+  return executiveAddImpl( e, scheduledTime, action, env, 0, envFree );
+}
+
+size_t executiveAddWithEnvSize( Executive* e,
+								struct timeval* scheduledTime,
+								Action action, void* env, size_t envSize,
+								void (*envFree)(void*) ) {
+  return executiveAddImpl( e, scheduledTime, action, env, envSize, envFree );
+}
+
+void* executiveAddInline( Executive* thiz,
+						  struct timeval* scheduledTime, Action action,
+						  size_t envSize, void (*envDestroy)(void*) ) {
+  if( envSize > EXECUTIVE_INLINE_ENV_SIZE )
+	return NULL;
+  executiveLock( thiz );
+  Event* e = NULL;
+  if( executiveAdmit( thiz, EVENT_COST ) )
+	e = executiveEventNew( thiz, scheduledTime, action, NULL, envDestroy );
+  if( e ) {
+	e->env = e->inlineEnv.bytes;
+	executiveCharge( thiz, e, 0 );
+	storeInsert( thiz, e );
+	executiveChanged( thiz, 1 );
+  }
+  executiveUnlock( thiz );
+  return e ? e->env : NULL;
 }
 
+size_t executiveAddWithStorage( Executive* thiz,
+								ExecutiveEventStorage* storage,
+								struct timeval* scheduledTime, Action action,
+								void* env ) {
+  executiveLock( thiz );
+  size_t result = EXECUTIVE_FULL;
+  if( executiveAdmit( thiz, 0 ) ) {
+	Event* e = (Event*)storage;
+	executiveEventInit( e, thiz, scheduledTime, action, env, NULL );
+	e->external = true;
+	executiveCharge( thiz, e, 0 );
+	storeInsert( thiz, e );
+	executiveChanged( thiz, 1 );
+	result = executiveLength( thiz );
+  }
+  executiveUnlock( thiz );
+  return result;
+}
+
+/*
+  The Events of a batch share one allocation, headed by an EventBlock
+  counting those not yet free'd.  The last one out frees the block.
+*/
+typedef struct EventBlock {
+  union {
+	size_t live;
+	max_align_t align;
+  };
+} EventBlock;
+
+/**
+ * The batch is first chained, via the Events' next links, in spec
+ * order, then merge-sorted (stable, so equal times keep spec order),
+ * then merged into the store in one pass.
+ */
+size_t executiveAddBatch( Executive* thiz, const EventSpec* specs, size_t n ) {
+  executiveLock( thiz );
+  size_t result = executiveAddBatchImpl( thiz, specs, n );
+  executiveUnlock( thiz );
+  return result;
+}
 
 /**
  * OK to return the sentinel, aka the armageddon, here.  This will
  * happen if/when the executive is empty.
  */
 struct timeval* executivePeek( Executive* thiz ) {
-  Event* head = (Event*)g_list_nth_data( thiz->events, 0 );
+  Event* head = executiveHead( thiz );
   return &head->scheduledTime;
 }
 
 void executiveFire( Executive* thiz, struct timeval* actualTime ) {
-  Event* head = (Event*)g_list_nth_data( thiz->events, 0 );
-  // the sentinel can never be fired/removed...
-  if( head == thiz->sentinel )
+  Event* head = executivePop( thiz, NULL );
+  if( !head )
 	return;
-  thiz->events = g_list_remove( thiz->events, head );
+
+  /*
+	Caller-owned storage may be reused, even re-added, by the Action
+	itself, so is not touched once the Action is called.
+  */
+  bool external = head->external;
 
   // we permit null actions, of course not very useful!
   if( head->action ) {
-	(head->action)( head, actualTime );
+	bool watched = thiz->watchdog;
+	if( watched ) {
+	  // a seqlock write: 'firing' is 0 here, the fence keeping it so
+	  __atomic_thread_fence( __ATOMIC_RELEASE );
+	  __atomic_store_n( &thiz->firingAction, head->action,
+						__ATOMIC_RELAXED );
+	  __atomic_store_n( &thiz->firingScheduled.tv_sec,
+						head->scheduledTime.tv_sec, __ATOMIC_RELAXED );
+	  __atomic_store_n( &thiz->firingScheduled.tv_usec,
+						head->scheduledTime.tv_usec, __ATOMIC_RELAXED );
+	  __atomic_store_n( &thiz->firing, ++thiz->firingSerial,
+						__ATOMIC_RELEASE );
+	}
+	if( thiz->profile )
+	  executiveProfileCall( thiz, head, actualTime );
+	else
+	  (head->action)( head, actualTime );
+	if( watched )
+	  __atomic_store_n( &thiz->firing, 0, __ATOMIC_RELEASE );
   }
-  executiveEventFree( head );
+  if( !external )
+	executiveEventFree( head );
 }
 
 /*
-  the number of user Events is one less than the actual length, which
-  includes the sentinel
+  The sentinel is not counted, and the timeout queues keep their own
+  counts, so this is O(number of timeout queues).
 */
 size_t executiveLength( Executive* thiz ) {
-  return g_list_length( thiz->events ) - 1;
+  size_t result = thiz->length + thiz->childLength;
+  for( ExecutiveTimeoutQueue* q = thiz->timeoutQueues; q; q = q->next )
+	result += q->events.length;
+  return result;
 }
 
 /**
@@ -143,171 +368,1125 @@ size_t executiveLength( Executive* thiz ) {
    does NOT invoke their Actions
 */
 size_t executiveClear( Executive* thiz ) {
-  size_t result = 0;
-  while( true ) {
-	Event* head = (Event*)g_list_nth_data( thiz->events, 0 );
-	if( head == thiz->sentinel )
-	  break;
-	thiz->events = g_list_remove( thiz->events, head );
-	executiveEventFree( head );
-	result++;
-  }
-  return result;
+  return executiveClearMatching( thiz, NULL, NULL );
 }
 
 /**
  * @result number of events removed
  */
 size_t executiveClearMatchingTime( Executive* thiz, struct timeval* tv ) {
-  size_t result = 0;
-  int index = 0;
-  while( true ) {
-	Event* el = (Event*)g_list_nth_data( thiz->events, index );
-	if( el == thiz->sentinel )
-	  break;
-	// can short-circuit the search since time-ordered list...
-	int cmp = timercmp( &el->scheduledTime, tv, > );
-	if( cmp )
-	  break;
-	cmp = timercmp( &el->scheduledTime, tv, == );
-	if( cmp ) {
-	  thiz->events = g_list_remove( thiz->events, el );
-	  executiveEventFree( el );
-	  result++;
+  return executiveClearMatching( thiz, eventMatchesTime, tv );
+}
+
+/**
+ * @result number of events removed
+ */
+size_t executiveClearMatchingAction( Executive* thiz, Action a ) {
+  Event key = { .action = a };
+  return executiveClearMatching( thiz, eventMatchesAction, &key );
+}
+
+/**
+ * @result number of events removed
+ */
+size_t executiveClearMatchingEnv( Executive* thiz, void* env ) {
+  return executiveClearMatching( thiz, eventMatchesEnv, env );
+}
+
+/**
+ * @result number of events removed
+ */
+size_t executiveClearMatchingActionAndEnv( Executive* thiz, 
+										Action a, void* env ) {
+  Event key = { .action = a, .env = env };
+  return executiveClearMatching( thiz, eventMatchesActionAndEnv, &key );
+}
+
+/**
+ * Each of src's store and timeout queues is in time order already, so
+ * the matching Events come off it as a sorted chain, which is then
+ * merged into dst's counterpart in one pass.
+ *
+ * @result number of events moved
+ */
+size_t executiveMigrate( Executive* src, Executive* dst,
+						 bool (*pred)( Event*, void* ), void* ctx ) {
+  if( src == dst )
+	return 0;
+
+  // two trees maybe, locked in a fixed order, so no deadlock
+  Executive* first = executiveRoot( src );
+  Executive* second = executiveRoot( dst );
+  if( first > second ) {
+	Executive* t = first;
+	first = second;
+	second = t;
+  }
+  executiveLock( first );
+  if( second != first )
+	executiveLock( second );
+
+  size_t result;
+  Event* chain = storeExtractMatching( src, pred, ctx, &result );
+  for( Event* e = chain; e; e = e->next )
+	executiveAdopt( dst, e );
+  storeMerge( dst, chain, result );
+  for( ExecutiveTimeoutQueue* q = src->timeoutQueues; q; q = q->next )
+	result += executiveMigrateQueue( q, dst, pred, ctx );
+
+  executiveChanged( src, -(ptrdiff_t)result );
+  executiveChanged( dst, (ptrdiff_t)result );
+
+  if( second != first )
+	executiveUnlock( second );
+  executiveUnlock( first );
+  return result;
+}
+
+size_t executiveMerge( Executive* dst, Executive* src ) {
+  return executiveMigrate( src, dst, NULL, NULL );
+}
+
+Executive* executiveEventExecutive( Event* e ) {
+  return e->executive;
+}
+
+struct timeval* executiveEventScheduledTime( Event* e ) {
+  return &e->scheduledTime;
+}
+
+void* executiveEventEnv( Event* e ) {
+  return e->env;
+}
+
+ExecutiveTimeoutQueue* executiveEventTimeoutQueue( Event* e ) {
+  return e->timeoutQueue;
+}
+
+int executiveAttachChild( Executive* thiz, Executive* child ) {
+  if( child->parent )
+	return -1;
+  // no cycles, child must not be thiz nor any ancestor of thiz
+  for( Executive* a = thiz; a; a = a->parent )
+	if( a == child )
+	  return -1;
+  if( thiz->childrenLength == thiz->childrenCapacity ) {
+	size_t capacity = thiz->childrenCapacity ? 2 * thiz->childrenCapacity : 4;
+	Executive** children = (Executive**)realloc
+	  ( thiz->children, capacity * sizeof( Executive* ) );
+	if( !children )
+	  return -1;
+	thiz->children = children;
+	thiz->childrenCapacity = capacity;
+  }
+  size_t length = executiveLength( child );
+  child->parent = thiz;
+  child->headKey = *executivePeek( child );
+  child->parentIndex = thiz->childrenLength;
+  thiz->children[thiz->childrenLength++] = child;
+  childHeapSiftUp( thiz, child->parentIndex );
+  thiz->childLength += length;
+  executiveChanged( thiz, (ptrdiff_t)length );
+  return 0;
+}
+
+int executiveDetachChild( Executive* thiz, Executive* child ) {
+  if( child->parent != thiz )
+	return -1;
+  size_t i = child->parentIndex;
+  size_t last = --thiz->childrenLength;
+  if( i != last ) {
+	childHeapSwap( thiz, i, last );
+	Executive* moved = thiz->children[i];
+	childHeapSiftUp( thiz, i );
+	childHeapSiftDown( thiz, moved->parentIndex );
+  }
+  child->parent = NULL;
+  size_t length = executiveLength( child );
+  thiz->childLength -= length;
+  executiveChanged( thiz, -(ptrdiff_t)length );
+  return 0;
+}
+
+Executive* executiveParent( Executive* thiz ) {
+  return thiz->parent;
+}
+
+void executiveSetLimits( Executive* thiz, size_t maxEvents, size_t maxBytes ) {
+  thiz->maxEvents = maxEvents;
+  thiz->maxBytes = maxBytes;
+}
+
+void executiveSetWatermarks( Executive* thiz, size_t high, size_t low,
+							 void (*callback)( Executive*, bool, void* ),
+							 void* arg ) {
+  thiz->highWatermark = high;
+  thiz->lowWatermark = low < high ? low : high;
+  thiz->watermark = callback;
+  thiz->watermarkArg = arg;
+  thiz->aboveWatermark = false;
+}
+
+size_t executiveBytes( Executive* thiz ) {
+  return thiz->bytes;
+}
+
+ExecutiveTimeoutQueue* executiveTimeoutQueue( Executive* thiz,
+											  struct timeval* duration ) {
+  executiveLock( thiz );
+  ExecutiveTimeoutQueue* result = executiveTimeoutQueueFind( thiz, duration );
+  executiveUnlock( thiz );
+  return result;
+}
+
+Event* executiveTimeoutAdd( ExecutiveTimeoutQueue* q, struct timeval* now,
+							Action action, void* env ) {
+  struct timeval scheduledTime;
+  timeradd( now, &q->duration, &scheduledTime );
+  executiveLock( q->executive );
+  Event* result = NULL;
+  if( executiveAdmit( q->executive, sizeof( Event ) ) )
+	result = executiveEventNew( q->executive, &scheduledTime,
+								action, env, NULL );
+  if( result ) {
+	result->timeoutQueue = q;
+	executiveCharge( q->executive, result, 0 );
+	executiveTimeoutQueueAppend( q, result );
+	executiveChanged( q->executive, 1 );
+  }
+  executiveUnlock( q->executive );
+  return result;
+}
+
+void executiveTimeoutTouch( Event* e, struct timeval* now ) {
+  ExecutiveTimeoutQueue* q = e->timeoutQueue;
+  executiveLock( q->executive );
+  eventListUnlink( &q->events, e );
+  timeradd( now, &q->duration, &e->scheduledTime );
+  executiveTimeoutQueueAppend( q, e );
+  executiveChanged( q->executive, 0 );
+  executiveUnlock( q->executive );
+}
+
+void executiveTimeoutCancel( Event* e ) {
+  Executive* thiz = e->timeoutQueue->executive;
+  executiveLock( thiz );
+  eventListUnlink( &e->timeoutQueue->events, e );
+  executiveEventFree( e );
+  executiveChanged( thiz, -1 );
+  executiveUnlock( thiz );
+}
+
+void executiveEventCancel( Event* e ) {
+  Executive* owner = e->executive;
+  executiveLock( owner );
+  executiveUnlink( owner, e );
+  executiveEventFree( e );
+  executiveChanged( owner, -1 );
+  executiveUnlock( owner );
+}
+
+Event* executivePop( Executive* thiz, struct timeval* by ) {
+  Event* head = executiveHead( thiz );
+  // the sentinel can never be fired/removed...
+  if( head == thiz->sentinel )
+	return NULL;
+  if( by && timercmp( &head->scheduledTime, by, > ) )
+	return NULL;
+  // which may be a descendant's Event, not our own
+  Executive* owner = head->executive;
+  executiveUnlink( owner, head );
+  executiveRefund( head );
+  executiveChanged( owner, -1 );
+  return head;
+}
+
+size_t executiveTimeoutQueueLength( ExecutiveTimeoutQueue* q ) {
+  return q->events.length;
+}
+
+/******************************* STATICS **********************************/
+
+static size_t executiveAddImpl( Executive* thiz,
+								struct timeval* scheduledTime, 
+								Action action, void* env, size_t envSize,
+								void (*envFree)(void*) ) {
+
+  executiveLock( thiz );
+  size_t result = EXECUTIVE_FULL;
+  Event* e = NULL;
+  if( executiveAdmit( thiz, EVENT_COST + envSize ) )
+	e = executiveEventNew( thiz, scheduledTime, action, env, envFree );
+  if( e ) {
+	executiveCharge( thiz, e, envSize );
+	storeInsert( thiz, e );
+	executiveChanged( thiz, 1 );
+	result = executiveLength( thiz );
+  }
+  executiveUnlock( thiz );
+  return result;
+}
+
+static size_t executiveAddBatchImpl( Executive* thiz,
+									 const EventSpec* specs, size_t n ) {
+  if( thiz->maxEvents && executiveOwnLength( thiz ) + n > thiz->maxEvents )
+	return EXECUTIVE_FULL;
+  if( thiz->maxBytes && thiz->bytes + n * EVENT_COST > thiz->maxBytes )
+	return EXECUTIVE_FULL;
+
+  // a static Executive takes its free slots, else one block for all
+  EventBlock* block = NULL;
+  if( thiz->isStatic ) {
+	size_t available = 0;
+	for( Event* e = thiz->freeEvents; e && available < n; e = e->next )
+	  available++;
+	if( available < n )
+	  return EXECUTIVE_FULL;
+  } else if( n ) {
+	block = malloc( sizeof( EventBlock ) + n * sizeof( Event ) );
+	if( !block )
+	  return EXECUTIVE_FULL;
+	block->live = n;
+  }
+
+  Event* chain = NULL;
+  Event** tail = &chain;
+  for( size_t i = 0; i < n; i++ ) {
+	struct timeval t = specs[i].scheduledTime;
+	Event* e;
+	if( block ) {
+	  e = (Event*)(block + 1) + i;
+	  executiveEventInit( e, thiz, &t, specs[i].action, specs[i].env, NULL );
+	  e->block = block;
 	} else {
-	  index++;
+	  e = executiveEventNew( thiz, &t, specs[i].action, specs[i].env, NULL );
 	}
+	executiveCharge( thiz, e, 0 );
+	*tail = e;
+	tail = &e->next;
   }
+  *tail = NULL;
+
+  storeMerge( thiz, eventChainSort( chain, n ), n );
+  executiveChanged( thiz, (ptrdiff_t)n );
+  return executiveLength( thiz );
+}
+
+static void executiveInit( Executive* thiz ) {
+  storeInit( thiz );
+  thiz->length = 0;
+  thiz->timeoutQueues = NULL;
+  thiz->loop = NULL;
+  thiz->parent = NULL;
+  thiz->parentIndex = 0;
+  thiz->children = NULL;
+  thiz->childrenLength = thiz->childrenCapacity = 0;
+  thiz->childLength = 0;
+  thiz->maxEvents = thiz->maxBytes = thiz->bytes = 0;
+  thiz->highWatermark = thiz->lowWatermark = 0;
+  thiz->watermark = NULL;
+  thiz->watermarkArg = NULL;
+  thiz->aboveWatermark = false;
+  thiz->mutex = NULL;
+  thiz->debounces = NULL;
+  thiz->profile = NULL;
+  thiz->watchdog = NULL;
+  thiz->firing = thiz->firingSerial = 0;
+}
+
+/**
+ * Memory for an Event (or timeout queue): from the free list of a
+ * static Executive, else the heap.  NULL if neither can oblige.
+ */
+static void* executiveSlotAlloc( Executive* thiz ) {
+  if( !thiz || !thiz->isStatic )
+	return malloc( sizeof( Event ) );
+  Event* result = thiz->freeEvents;
+  if( result )
+	thiz->freeEvents = result->next;
   return result;
 }
 
 /**
- * @result number of events removed
+ * The earliest Event is at the head of either the main store or one of
+ * the timeout queues.  On a tie, the main store wins.  Returns the
+ * sentinel if the Executive is empty.
  */
-size_t executiveClearMatchingAction( Executive* thiz, Action a ) {
-  size_t result = 0;
-  int index = 0;
+static Event* executiveHead( Executive* thiz ) {
+  Event* result = storeHead( thiz );
+  for( ExecutiveTimeoutQueue* q = thiz->timeoutQueues; q; q = q->next ) {
+	Event* head = q->events.head;
+	if( head && timercmp( &head->scheduledTime, &result->scheduledTime, < ) )
+	  result = head;
+  }
+  if( thiz->childrenLength ) {
+	Executive* child = thiz->children[0];
+	if( timercmp( &child->headKey, &result->scheduledTime, < ) )
+	  result = executiveHead( child );
+  }
+  return result;
+}
+
+/*
+  Events were added to (delta > 0) or removed from (delta < 0) thiz,
+  or merely moved. Tell our ancestors, each of which re-sorts the
+  child concerned in its heap, but only if that child's head time
+  really did change, so O(log k) per level at worst, O(1) typically.
+*/
+static void executiveChanged( Executive* thiz, ptrdiff_t delta ) {
+  if( thiz->watermark ) {
+	size_t length = executiveOwnLength( thiz );
+	bool above = thiz->aboveWatermark ? length > thiz->lowWatermark :
+	  length > thiz->highWatermark;
+	if( above != thiz->aboveWatermark ) {
+	  thiz->aboveWatermark = above;
+	  thiz->watermark( thiz, above, thiz->watermarkArg );
+	}
+  }
+  for( Executive* child = thiz; child->parent; child = child->parent ) {
+	Executive* p = child->parent;
+	p->childLength += delta;
+	struct timeval* head = executivePeek( child );
+	if( timercmp( head, &child->headKey, == ) )
+	  continue;
+	child->headKey = *head;
+	childHeapSiftUp( p, child->parentIndex );
+	childHeapSiftDown( p, child->parentIndex );
+  }
+}
+
+// Our own Events, bar those of any children
+static size_t executiveOwnLength( Executive* thiz ) {
+  return executiveLength( thiz ) - thiz->childLength;
+}
+
+/*
+  Would an Event costing 'bytes' fit within our limits?  Checked before
+  any allocation, so a rejected add has no effect at all.
+*/
+static bool executiveAdmit( Executive* thiz, size_t bytes ) {
+  if( thiz->maxEvents && executiveOwnLength( thiz ) >= thiz->maxEvents )
+	return false;
+  if( thiz->maxBytes && thiz->bytes + bytes > thiz->maxBytes )
+	return false;
+  return true;
+}
+
+static void executiveCharge( Executive* thiz, Event* e, size_t envSize ) {
+  size_t charge = envSize;
+  if( !e->external )
+	charge += e->timeoutQueue ? sizeof( Event ) : EVENT_COST;
+  e->charge = charge;
+  thiz->bytes += charge;
+}
+
+// Idempotent, an Event fired is refunded before its Action is called
+static void executiveRefund( Event* e ) {
+  if( e->charge ) {
+	e->executive->bytes -= e->charge;
+	e->charge = 0;
+  }
+}
+
+static bool childHeapLess( Executive* p, size_t i, size_t j ) {
+  return timercmp( &p->children[i]->headKey, &p->children[j]->headKey, < );
+}
+
+static void childHeapSwap( Executive* p, size_t i, size_t j ) {
+  Executive* c = p->children[i];
+  p->children[i] = p->children[j];
+  p->children[j] = c;
+  p->children[i]->parentIndex = i;
+  p->children[j]->parentIndex = j;
+}
+
+static void childHeapSiftUp( Executive* p, size_t i ) {
+  while( i > 0 && childHeapLess( p, i, (i - 1) / 2 ) ) {
+	childHeapSwap( p, i, (i - 1) / 2 );
+	i = (i - 1) / 2;
+  }
+}
+
+static void childHeapSiftDown( Executive* p, size_t i ) {
   while( true ) {
-	Event* el = (Event*)g_list_nth_data( thiz->events, index );
-	if( el == thiz->sentinel )
-	  break;
-	if( el->action == a ) {
-	  thiz->events = g_list_remove( thiz->events, el );
-	  executiveEventFree( el );
-	  result++;
-	} else {
-	  index++;
+	size_t least = i;
+	size_t l = 2 * i + 1, r = l + 1;
+	if( l < p->childrenLength && childHeapLess( p, l, least ) )
+	  least = l;
+	if( r < p->childrenLength && childHeapLess( p, r, least ) )
+	  least = r;
+	if( least == i )
+	  return;
+	childHeapSwap( p, i, least );
+	i = least;
+  }
+}
+
+static void executiveUnlink( Executive* thiz, Event* e ) {
+  if( e->timeoutQueue )
+	eventListUnlink( &e->timeoutQueue->events, e );
+  else
+	storeRemove( thiz, e );
+}
+
+/*
+  A linear search, but of the timeout queues only, of which there are
+  expected to be very few, one per distinct duration.  The caller
+  holds the lock.
+*/
+static ExecutiveTimeoutQueue* executiveTimeoutQueueFind( Executive* thiz,
+														 struct timeval* duration ) {
+  ExecutiveTimeoutQueue** qp = &thiz->timeoutQueues;
+  while( *qp && !timercmp( &(*qp)->duration, duration, == ) )
+	qp = &(*qp)->next;
+  ExecutiveTimeoutQueue* result = *qp;
+  if( !result ) {
+	result = (ExecutiveTimeoutQueue*)executiveSlotAlloc( thiz );
+	if( result ) {
+	  result->executive = thiz;
+	  result->duration = *duration;
+	  eventListInit( &result->events );
+	  result->next = NULL;
+	  *qp = result;
 	}
   }
   return result;
 }
 
+/*
+  Time-ordering on the queue relies on 'now' being monotonic across
+  adds. If it steps backwards, we clamp to the tail's time.
+*/
+static void executiveTimeoutQueueAppend( ExecutiveTimeoutQueue* q,
+										 Event* e ) {
+  Event* last = q->events.tail;
+  if( last && timercmp( &e->scheduledTime, &last->scheduledTime, < ) )
+	e->scheduledTime = last->scheduledTime;
+  eventListInsertAfter( &q->events, last, e );
+}
+
 /**
+ * Discard those Events, in the store and on all timeout queues,
+ * satisfying 'match', or all of them if match is NULL.
+ *
  * @result number of events removed
  */
-size_t executiveClearMatchingEnv( Executive* thiz, gpointer env ) {
-  size_t result = 0;
-  int index = 0;
-  while( TRUE ) {
-	Event* el = (Event*)g_list_nth_data( thiz->events, index );
-	if( el == thiz->sentinel )
-	  break;
-	if( el->env == env ) {
-	  thiz->events = g_list_remove( thiz->events, el );
-	  executiveEventFree( el );
-	  result++;
-	} else {
-	  index++;
+static size_t executiveClearMatching( Executive* thiz,
+									  bool (*match)( Event*, void* ),
+									  void* arg ) {
+  executiveLock( thiz );
+  size_t result = storeClearMatching( thiz, match, arg );
+  for( ExecutiveTimeoutQueue* q = thiz->timeoutQueues; q; q = q->next )
+	result += eventListClearMatching( &q->events, NULL, match, arg );
+  executiveChanged( thiz, -(ptrdiff_t)result );
+  executiveUnlock( thiz );
+  return result;
+}
+
+/*
+  Move q's matching Events to dst's queue of the same duration.  If
+  dst can't have such a queue (static, and full), they stay put.
+*/
+static size_t executiveMigrateQueue( ExecutiveTimeoutQueue* q,
+									 Executive* dst,
+									 bool (*pred)( Event*, void* ),
+									 void* ctx ) {
+  size_t result;
+  Event* chain = eventListExtractMatching( &q->events, NULL,
+										   pred, ctx, &result );
+  if( !chain )
+	return 0;
+  // dst's lock is held already, and is not recursive
+  ExecutiveTimeoutQueue* target = executiveTimeoutQueueFind( dst,
+															 &q->duration );
+  if( !target ) {
+	eventListMerge( &q->events, chain );
+	return 0;
+  }
+  for( Event* e = chain; e; e = e->next ) {
+	executiveAdopt( dst, e );
+	e->timeoutQueue = target;
+  }
+  eventListMerge( &target->events, chain );
+  return result;
+}
+
+/*
+  Transfer e, and its charge, to dst.  It keeps its pool, if any.  A
+  debounce Event's key goes with it.
+*/
+static void executiveAdopt( Executive* dst, Event* e ) {
+  e->executive->bytes -= e->charge;
+  dst->bytes += e->charge;
+  e->executive = dst;
+  executiveDebounceAdopt( dst, e );
+}
+
+static Executive* executiveRoot( Executive* thiz ) {
+  while( thiz->parent )
+	thiz = thiz->parent;
+  return thiz;
+}
+
+/*
+  The mutex, if any, is that of the root of a tree of Executives, since
+  changes to a child reach its ancestors.
+*/
+static void executiveLock( Executive* thiz ) {
+  thiz = executiveRoot( thiz );
+  if( thiz->mutex )
+	pthread_mutex_lock( thiz->mutex );
+}
+
+static void executiveUnlock( Executive* thiz ) {
+  thiz = executiveRoot( thiz );
+  if( thiz->mutex )
+	pthread_mutex_unlock( thiz->mutex );
+}
+
+/*
+  Stable merge sort of a chain of Events, linked via next.  A chain
+  already in order, the common case, costs just the one pass.
+*/
+static Event* eventChainSort( Event* chain, size_t length ) {
+  if( length < 2 )
+	return chain;
+  bool sorted = true;
+  for( Event* e = chain; e->next && sorted; e = e->next )
+	sorted = !timercmp( &e->scheduledTime, &e->next->scheduledTime, > );
+  if( sorted )
+	return chain;
+
+  size_t half = length / 2;
+  Event* mid = chain;
+  for( size_t i = 1; i < half; i++ )
+	mid = mid->next;
+  Event* second = mid->next;
+  mid->next = NULL;
+  Event* a = eventChainSort( chain, half );
+  Event* b = eventChainSort( second, length - half );
+
+  Event* result = NULL;
+  Event** tail = &result;
+  while( a && b ) {
+	// b only if strictly earlier, so stable
+	Event** from = timercmp( &b->scheduledTime, &a->scheduledTime, < ) ?
+	  &b : &a;
+	*tail = *from;
+	tail = &(*from)->next;
+	*from = (*from)->next;
+  }
+  *tail = a ? a : b;
+  return result;
+}
+
+static bool eventMatchesTime( Event* e, void* tv ) {
+  return timercmp( &e->scheduledTime, (struct timeval*)tv, == );
+}
+
+static bool eventMatchesAction( Event* e, void* key ) {
+  return e->action == ((Event*)key)->action;
+}
+
+static bool eventMatchesEnv( Event* e, void* env ) {
+  return e->env == env;
+}
+
+static bool eventMatchesActionAndEnv( Event* e, void* key ) {
+  return e->action == ((Event*)key)->action && e->env == ((Event*)key)->env;
+}
+
+static void eventListInit( EventList* l ) {
+  l->head = l->tail = NULL;
+  l->length = 0;
+}
+
+// Link e in after pos, or at the head if pos is NULL
+static void eventListInsertAfter( EventList* l, Event* pos, Event* e ) {
+  e->prev = pos;
+  e->next = pos ? pos->next : l->head;
+  if( e->next )
+	e->next->prev = e;
+  else
+	l->tail = e;
+  if( pos )
+	pos->next = e;
+  else
+	l->head = e;
+  l->length++;
+}
+
+static void eventListUnlink( EventList* l, Event* e ) {
+  if( e->prev )
+	e->prev->next = e->next;
+  else
+	l->head = e->next;
+  if( e->next )
+	e->next->prev = e->prev;
+  else
+	l->tail = e->prev;
+  e->prev = e->next = NULL;
+  l->length--;
+}
+
+/**
+ * Unlink all Events before 'end' (NULL for the whole list) satisfying
+ * 'match', or all of them if match is NULL, chaining them, in list
+ * order, via their next links.
+ */
+static Event* eventListExtractMatching( EventList* l, Event* end,
+										bool (*match)( Event*, void* ),
+										void* arg, size_t* length ) {
+  Event* result = NULL;
+  Event** tail = &result;
+  *length = 0;
+  Event* el = l->head;
+  while( el != end ) {
+	Event* next = el->next;
+	if( !match || match( el, arg ) ) {
+	  eventListUnlink( l, el );
+	  *tail = el;
+	  tail = &el->next;
+	  (*length)++;
 	}
+	el = next;
   }
+  *tail = NULL;
   return result;
 }
 
 /**
- * @result number of events removed
+ * Merge a time-ordered chain into a time-ordered list, each Event
+ * going after any of equal time.
  */
-size_t executiveClearMatchingActionAndEnv( Executive* thiz, 
-										Action a, gpointer env ) {
+static void eventListMerge( EventList* l, Event* chain ) {
+  Event* pos = NULL;
+  Event* at = l->head;
+  while( chain ) {
+	Event* e = chain;
+	chain = e->next;
+	while( at && !timercmp( &at->scheduledTime, &e->scheduledTime, > ) ) {
+	  pos = at;
+	  at = at->next;
+	}
+	eventListInsertAfter( l, pos, e );
+	pos = e;
+  }
+}
+
+/**
+ * Free all Events before 'end' (NULL for the whole list) satisfying
+ * 'match', or all of them if match is NULL.
+ */
+static size_t eventListClearMatching( EventList* l, Event* end,
+									  bool (*match)( Event*, void* ),
+									  void* arg ) {
   size_t result = 0;
-  int index = 0;
-  while( true ) {
-	Event* el = (Event*)g_list_nth_data( thiz->events, index );
-	if( el == thiz->sentinel )
-	  break;
-	if( el->action == a && el->env == env ) {
-	  thiz->events = g_list_remove( thiz->events, el );
+  Event* el = l->head;
+  while( el != end ) {
+	Event* next = el->next;
+	if( !match || match( el, arg ) ) {
+	  eventListUnlink( l, el );
 	  executiveEventFree( el );
 	  result++;
-	} else {
-	  index++;
 	}
+	el = next;
   }
   return result;
 }
 
-Executive* executiveEventExecutive( Event* e ) {
-  return e->executive;
+#ifdef EXECUTIVE_GLIB
+
+/*
+  The GLib store: a GList, kept sorted via g_list_insert_sorted.  Each
+  Event costs a separate GList node, and removal of other than the
+  head is a linear search.
+*/
+
+// conforming to GLibCompareFunc, orders Events on an Executive
+static int executiveEventComparator( gconstpointer a, gconstpointer b ) {
+  Event* e1 = (Event*)a;
+  Event* e2 = (Event*)b;
+  struct timeval* tv1 = &e1->scheduledTime;
+  struct timeval* tv2 = &e2->scheduledTime;
+  if( timercmp( tv1, tv2, < ) )
+	return -1;
+  if( timercmp( tv1, tv2, > ) )
+	return 1;
+  return 0;
 }
 
-struct timeval* executiveEventScheduledTime( Event* e ) {
-  return &e->scheduledTime;
+static void storeInit( Executive* thiz ) {
+  thiz->events = g_list_insert_sorted( NULL, thiz->sentinel, 
+									   executiveEventComparator );
 }
 
-void* executiveEventEnv( Event* e ) {
-  return e->env;
+static void storeFree( Executive* thiz ) {
+  g_list_free( thiz->events );
 }
 
-/******************************* STATICS **********************************/
+static Event* storeHead( Executive* thiz ) {
+  return (Event*)thiz->events->data;
+}
 
-static size_t executiveAddImpl( Executive* thiz,
-								struct timeval* scheduledTime, 
-								Action action, 
-								gpointer env, void (*envFree)(gpointer) ) {
-  
-  Event* e = executiveEventNew( thiz, scheduledTime, action, env, envFree );
+static void storeInsert( Executive* thiz, Event* e ) {
   thiz->events = g_list_insert_sorted
 	( thiz->events, e, executiveEventComparator );
-  return executiveLength( thiz );
+  thiz->length++;
+}
+
+static void storeRemove( Executive* thiz, Event* e ) {
+  thiz->events = g_list_remove( thiz->events, e );
+  thiz->length--;
 }
 
+// As per storeInsert, a new Event goes before any of equal time
+static void storeMerge( Executive* thiz, Event* chain, size_t length ) {
+  GList* l = thiz->events;
+  while( chain ) {
+	Event* e = chain;
+	chain = e->next;
+	e->next = NULL;
+	while( l->data != thiz->sentinel &&
+		   executiveEventComparator( l->data, e ) < 0 )
+	  l = l->next;
+	thiz->events = g_list_insert_before( thiz->events, l, e );
+  }
+  thiz->length += length;
+}
+
+static size_t storeClearMatching( Executive* thiz,
+								  bool (*match)( Event*, void* ),
+								  void* arg ) {
+  size_t result = 0;
+  GList* l = thiz->events;
+  while( l->data != thiz->sentinel ) {
+	GList* next = l->next;
+	Event* el = (Event*)l->data;
+	if( !match || match( el, arg ) ) {
+	  thiz->events = g_list_delete_link( thiz->events, l );
+	  executiveEventFree( el );
+	  result++;
+	}
+	l = next;
+  }
+  thiz->length -= result;
+  return result;
+}
+
+static Event* storeExtractMatching( Executive* thiz,
+									bool (*match)( Event*, void* ),
+									void* arg, size_t* length ) {
+  Event* result = NULL;
+  Event** tail = &result;
+  *length = 0;
+  GList* l = thiz->events;
+  while( l->data != thiz->sentinel ) {
+	GList* next = l->next;
+	Event* el = (Event*)l->data;
+	if( !match || match( el, arg ) ) {
+	  thiz->events = g_list_delete_link( thiz->events, l );
+	  *tail = el;
+	  tail = &el->next;
+	  (*length)++;
+	}
+	l = next;
+  }
+  *tail = NULL;
+  thiz->length -= *length;
+  return result;
+}
+
+#elif defined(EXECUTIVE_RADIX)
+
+/*
+  The radix heap store.  Timer workloads are monotone, Events being
+  scheduled no earlier than the head, so each is bucketed by the
+  highest bit in which its time differs from 'last', the head time
+  when last asked for.  An insert is then a bit scan and a list
+  append, as is removal of any Event, and an Event moves down the
+  buckets at most 64 times in all, as storeHead refills buckets[0].
+  The rare Event due before 'last' goes instead in 'past', sorted as
+  per the list store, and so precedes all bucketed ones.  Events with
+  equal times need not fire in the order they were added.  Times
+  before the epoch are not supported.
+*/
+
+#define RADIX_BUCKETS 65
+
+static uint64_t radixKey( Event* e ) {
+  return (uint64_t)e->scheduledTime.tv_sec * 1000000 +
+	(uint64_t)e->scheduledTime.tv_usec;
+}
+
+static size_t radixBucket( RadixStore* r, uint64_t key ) {
+  return key == r->last ? 0 : 64 - __builtin_clzll( key ^ r->last );
+}
+
+static void radixAppend( RadixStore* r, Event* e ) {
+  size_t b = radixBucket( r, radixKey( e ) );
+  eventListInsertAfter( &r->buckets[b], r->buckets[b].tail, e );
+  if( b )
+	r->occupied |= UINT64_C(1) << (b - 1);
+}
+
+/*
+  If buckets[0] has emptied, 'last' advances to the earliest Event of
+  the lowest occupied bucket, all of whose Events then belong in lower
+  buckets, at least that earliest one in buckets[0].
+*/
+static void radixSettle( RadixStore* r ) {
+  if( r->buckets[0].head || !r->occupied )
+	return;
+  EventList* l = &r->buckets[__builtin_ctzll( r->occupied ) + 1];
+  uint64_t min = UINT64_MAX;
+  for( Event* e = l->head; e; e = e->next ) {
+	uint64_t key = radixKey( e );
+	if( key < min )
+	  min = key;
+  }
+  r->last = min;
+  r->occupied &= r->occupied - 1;
+  Event* chain = l->head;
+  eventListInit( l );
+  while( chain ) {
+	Event* e = chain;
+	chain = e->next;
+	radixAppend( r, e );
+  }
+}
+
+// After Events are taken from the buckets, en masse
+static void radixRecount( RadixStore* r ) {
+  for( size_t b = 1; b < RADIX_BUCKETS; b++ )
+	if( !r->buckets[b].head )
+	  r->occupied &= ~(UINT64_C(1) << (b - 1));
+}
+
+static void storeInit( Executive* thiz ) {
+  RadixStore* r = &thiz->events;
+  r->last = 0;
+  r->occupied = 0;
+  for( size_t b = 0; b < RADIX_BUCKETS; b++ )
+	eventListInit( &r->buckets[b] );
+  eventListInit( &r->past );
+}
+
+static void storeFree( Executive* thiz ) {
+  (void)thiz;
+}
+
+/*
+  Unlike the list stores, finding the head may move Events: 'last'
+  advances only here, so that Events added by the Action just fired,
+  typically due soon, are still no earlier than it.
+*/
+static Event* storeHead( Executive* thiz ) {
+  RadixStore* r = &thiz->events;
+  if( r->past.head )
+	return r->past.head;
+  radixSettle( r );
+  if( r->buckets[0].head )
+	return r->buckets[0].head;
+  return thiz->sentinel;
+}
+
+static void storeInsert( Executive* thiz, Event* e ) {
+  RadixStore* r = &thiz->events;
+  if( radixKey( e ) < r->last ) {
+	Event* pos = r->past.tail;
+	while( pos && timercmp( &pos->scheduledTime, &e->scheduledTime, > ) )
+	  pos = pos->prev;
+	eventListInsertAfter( &r->past, pos, e );
+  } else {
+	radixAppend( r, e );
+  }
+  thiz->length++;
+}
+
+/*
+  An Event stays in the bucket its key and 'last' name, since 'last'
+  only ever advances to within the lowest occupied bucket, leaving
+  higher bucketed Events' highest differing bits unchanged.
+*/
+static void storeRemove( Executive* thiz, Event* e ) {
+  RadixStore* r = &thiz->events;
+  uint64_t key = radixKey( e );
+  if( key < r->last ) {
+	eventListUnlink( &r->past, e );
+  } else {
+	size_t b = radixBucket( r, key );
+	eventListUnlink( &r->buckets[b], e );
+	if( b && !r->buckets[b].head )
+	  r->occupied &= ~(UINT64_C(1) << (b - 1));
+  }
+  thiz->length--;
+}
+
+// Inserts being O(1) anyway, the chain's order is of no help
+static void storeMerge( Executive* thiz, Event* chain, size_t length ) {
+  while( chain ) {
+	Event* e = chain;
+	chain = e->next;
+	storeInsert( thiz, e );
+  }
+  (void)length;
+}
+
+static size_t storeClearMatching( Executive* thiz,
+								  bool (*match)( Event*, void* ),
+								  void* arg ) {
+  RadixStore* r = &thiz->events;
+  size_t result = eventListClearMatching( &r->past, NULL, match, arg );
+  for( size_t b = 0; b < RADIX_BUCKETS; b++ )
+	result += eventListClearMatching( &r->buckets[b], NULL, match, arg );
+  radixRecount( r );
+  thiz->length -= result;
+  return result;
+}
+
+/*
+  Any Event in a lower bucket precedes all those in higher ones, so
+  only within buckets might the extracted chain be out of order.
+*/
+static Event* storeExtractMatching( Executive* thiz,
+									bool (*match)( Event*, void* ),
+									void* arg, size_t* length ) {
+  RadixStore* r = &thiz->events;
+  Event* result = eventListExtractMatching( &r->past, NULL,
+											match, arg, length );
+  Event** tail = &result;
+  while( *tail )
+	tail = &(*tail)->next;
+  for( size_t b = 0; b < RADIX_BUCKETS; b++ ) {
+	size_t n;
+	*tail = eventListExtractMatching( &r->buckets[b], NULL, match, arg, &n );
+	while( *tail )
+	  tail = &(*tail)->next;
+	*length += n;
+  }
+  radixRecount( r );
+  thiz->length -= *length;
+  return eventChainSort( result, *length );
+}
+
+#else
+
+/*
+  The intrusive store: an EventList, the links embedded in the Events
+  themselves, so no allocation beyond the Event, and O(1) removal.
+  Insertion scans backwards from the tail, since newly added Events
+  are typically later than most already pending.  Events with equal
+  times fire in the order they were added.
+*/
+
+static void storeInit( Executive* thiz ) {
+  eventListInit( &thiz->events );
+  eventListInsertAfter( &thiz->events, NULL, thiz->sentinel );
+}
+
+static void storeFree( Executive* thiz ) {
+  (void)thiz;
+}
+
+static Event* storeHead( Executive* thiz ) {
+  return thiz->events.head;
+}
+
+static void storeInsert( Executive* thiz, Event* e ) {
+  Event* pos = thiz->sentinel->prev;
+  while( pos && timercmp( &pos->scheduledTime, &e->scheduledTime, > ) )
+	pos = pos->prev;
+  eventListInsertAfter( &thiz->events, pos, e );
+  thiz->length++;
+}
+
+static void storeRemove( Executive* thiz, Event* e ) {
+  eventListUnlink( &thiz->events, e );
+  thiz->length--;
+}
+
+// As per storeInsert, a new Event goes after any of equal time
+static void storeMerge( Executive* thiz, Event* chain, size_t length ) {
+  Event* pos = thiz->events.head;
+  while( chain ) {
+	Event* e = chain;
+	chain = e->next;
+	while( pos != thiz->sentinel &&
+		   !timercmp( &pos->scheduledTime, &e->scheduledTime, > ) )
+	  pos = pos->next;
+	eventListInsertAfter( &thiz->events, pos->prev, e );
+  }
+  thiz->length += length;
+}
+
+static size_t storeClearMatching( Executive* thiz,
+								  bool (*match)( Event*, void* ),
+								  void* arg ) {
+  size_t result = eventListClearMatching( &thiz->events, thiz->sentinel,
+										  match, arg );
+  thiz->length -= result;
+  return result;
+}
+
+static Event* storeExtractMatching( Executive* thiz,
+									bool (*match)( Event*, void* ),
+									void* arg, size_t* length ) {
+  Event* result = eventListExtractMatching( &thiz->events, thiz->sentinel,
+											match, arg, length );
+  thiz->length -= *length;
+  return result;
+}
+
+#endif
+
 static Event* executiveEventNew( Executive* source,
 								 struct timeval* scheduledTime, Action action, 
-								 gpointer env, void (*envFree)(gpointer) ) {
-  Event* result = (Event*)malloc( sizeof( Event ) );
+								 void* env, void (*envFree)(void*) ) {
+  Event* result = (Event*)executiveSlotAlloc( source );
   if( !result )
 	return NULL;
   executiveEventInit( result, source, scheduledTime, action, env, envFree );
+  if( source && source->isStatic )
+	result->pool = source;
   return result;
 }
 
 static void executiveEventInit( Event* thiz, Executive* source,
 								struct timeval* scheduledTime, 
 								Action action,
-								gpointer env, void (*envFree)(gpointer) ) {
+								void* env, void (*envFree)(void*) ) {
   thiz->executive = source;
   thiz->scheduledTime = *scheduledTime;
   thiz->action = action;
   thiz->env = env;
   thiz->envFree = envFree;
+  thiz->prev = thiz->next = NULL;
+  thiz->timeoutQueue = NULL;
+  thiz->pool = NULL;
+  thiz->external = false;
+  thiz->charge = 0;
+  thiz->block = NULL;
 }
 
-// conforming to GLibCompareFunc, orders Events on an Executive
-int executiveEventComparator( gconstpointer a, gconstpointer b ) {
-  Event* e1 = (Event*)a;
-  Event* e2 = (Event*)b;
-  struct timeval* tv1 = &e1->scheduledTime;
-  struct timeval* tv2 = &e2->scheduledTime;
-  if( timercmp( tv1, tv2, < ) )
-	return -1;
-  if( timercmp( tv1, tv2, > ) )
-	return 1;
-  return 0;
-}
-
-static void executiveEventFree( Event* thiz ) {
+void executiveEventFree( Event* thiz ) {
+  executiveRefund( thiz );
+  // the env may well own caller-supplied storage, so look first
+  bool external = thiz->external;
   if( thiz->env && thiz->envFree )
 	(*thiz->envFree)( thiz->env );
-  free( thiz );
+  if( external )
+	return;
+  Executive* pool = thiz->pool;
+  if( pool ) {
+	thiz->next = pool->freeEvents;
+	pool->freeEvents = thiz;
+  } else if( thiz->block ) {
+	if( --thiz->block->live == 0 )
+	  free( thiz->block );
+  } else {
+	free( thiz );
+  }
 }
 
 // eof
@@ -0,0 +1,303 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "executive/input.h"
+#include "executive/loop.h"
+#include "executive-private.h"
+
+/*
+  The buffer is a ring of 'capacity' bytes, holding 'length'
+  unconsumed bytes from offset 'start'.  It is allocated with
+  maxRecord bytes of slack beyond the ring, so that a record wrapping
+  round the end can be made contiguous by copying just its wrapped
+  part into that slack.  Only such wrapped records are ever copied.
+*/
+struct ExecutiveInput {
+  Executive* executive;
+  int fd;
+
+  // 0 for delimited records
+  unsigned prefixSize;
+  char delimiter;
+  size_t maxRecord;
+
+  InputAction action;
+  void* env;
+
+  char* buffer;
+  size_t capacity;
+  size_t size;
+  size_t start;
+  size_t length;
+
+  // delimited: leading bytes of the pending record known delimiter-free
+  size_t scanned;
+
+  // executiveInputFree called from within the action
+  bool delivering;
+  bool freed;
+};
+
+static ExecutiveInput* executiveInputNew( Executive* e, int fd,
+										  unsigned prefixSize, char delimiter,
+										  size_t maxRecord,
+										  InputAction action, void* env );
+static void inputReadable( Event* e, struct timeval* actualTime );
+static void inputParse( ExecutiveInput* thiz );
+static bool inputNextDelimited( ExecutiveInput* thiz, size_t* offset,
+								size_t* length, size_t* consumed );
+static bool inputNextPrefixed( ExecutiveInput* thiz, size_t* offset,
+							   size_t* length, size_t* consumed );
+static void inputDeliver( ExecutiveInput* thiz, size_t offset, size_t length );
+static void inputEnd( ExecutiveInput* thiz, int error );
+static void inputRelease( ExecutiveInput* thiz );
+
+ExecutiveInput* executiveInputDelimited( Executive* e, int fd,
+										 char delimiter, size_t maxRecord,
+										 InputAction action, void* env ) {
+  return executiveInputNew( e, fd, 0, delimiter, maxRecord, action, env );
+}
+
+ExecutiveInput* executiveInputPrefixed( Executive* e, int fd,
+										unsigned prefixSize, size_t maxRecord,
+										InputAction action, void* env ) {
+  if( prefixSize != 1 && prefixSize != 2 && prefixSize != 4 ) {
+	errno = EINVAL;
+	return NULL;
+  }
+  return executiveInputNew( e, fd, prefixSize, 0, maxRecord, action, env );
+}
+
+void executiveInputFree( ExecutiveInput* thiz ) {
+  executiveUnwatchFd( thiz->executive, thiz->fd );
+  if( thiz->delivering ) {
+	thiz->freed = true;
+	return;
+  }
+  inputRelease( thiz );
+}
+
+int executiveInputFd( ExecutiveInput* thiz ) {
+  return thiz->fd;
+}
+
+/******************************* STATICS **********************************/
+
+static ExecutiveInput* executiveInputNew( Executive* e, int fd,
+										  unsigned prefixSize, char delimiter,
+										  size_t maxRecord,
+										  InputAction action, void* env ) {
+  if( maxRecord == 0 ) {
+	errno = EINVAL;
+	return NULL;
+  }
+  ExecutiveInput* result = (ExecutiveInput*)malloc( sizeof( ExecutiveInput ) );
+  if( !result )
+	return NULL;
+  result->executive = e;
+  result->fd = fd;
+  result->prefixSize = prefixSize;
+  result->delimiter = delimiter;
+  result->maxRecord = maxRecord;
+  result->action = action;
+  result->env = env;
+  result->capacity = 2 * (maxRecord + prefixSize);
+  result->size = result->capacity + maxRecord;
+  result->start = result->length = result->scanned = 0;
+  result->delivering = result->freed = false;
+  result->buffer = executiveBufferGet( e, result->size );
+  if( !result->buffer ) {
+	free( result );
+	return NULL;
+  }
+  if( executiveWatchFd( e, fd, inputReadable, result ) ) {
+	inputRelease( result );
+	return NULL;
+  }
+  return result;
+}
+
+/*
+  One readv per wakeup, into the (up to two) free regions of the
+  ring, then deliver every complete record.
+*/
+static void inputReadable( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  ExecutiveInput* thiz = (ExecutiveInput*)executiveEventEnv( e );
+
+  size_t end = (thiz->start + thiz->length) % thiz->capacity;
+  size_t avail = thiz->capacity - thiz->length;
+  struct iovec iov[2];
+  int iovcnt = 1;
+  iov[0].iov_base = thiz->buffer + end;
+  iov[0].iov_len = avail < thiz->capacity - end ? avail :
+	thiz->capacity - end;
+  if( iov[0].iov_len < avail ) {
+	iov[1].iov_base = thiz->buffer;
+	iov[1].iov_len = avail - iov[0].iov_len;
+	iovcnt = 2;
+  }
+
+  ssize_t nin = readv( thiz->fd, iov, iovcnt );
+  if( nin < 0 ) {
+	if( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+	  inputEnd( thiz, errno );
+	return;
+  }
+  if( nin == 0 ) {
+	inputEnd( thiz, 0 );
+	return;
+  }
+  thiz->length += nin;
+  inputParse( thiz );
+}
+
+static void inputParse( ExecutiveInput* thiz ) {
+  thiz->delivering = true;
+  while( !thiz->freed ) {
+	size_t offset, length, consumed;
+	bool complete = thiz->prefixSize ?
+	  inputNextPrefixed( thiz, &offset, &length, &consumed ) :
+	  inputNextDelimited( thiz, &offset, &length, &consumed );
+	if( !complete )
+	  break;
+	inputDeliver( thiz, offset, length );
+	thiz->start = (thiz->start + consumed) % thiz->capacity;
+	thiz->length -= consumed;
+  }
+  thiz->delivering = false;
+  if( thiz->freed )
+	inputRelease( thiz );
+}
+
+/*
+  A record longer than maxRecord, delimited yet or not, ends the input
+  before any of it is delivered, since it would not fit the slack.
+*/
+static bool inputNextDelimited( ExecutiveInput* thiz, size_t* offset,
+								size_t* length, size_t* consumed ) {
+  // search at most two regions, first up to the ring's end
+  size_t from = (thiz->start + thiz->scanned) % thiz->capacity;
+  size_t todo = thiz->length - thiz->scanned;
+  while( todo > 0 ) {
+	size_t n = todo < thiz->capacity - from ? todo : thiz->capacity - from;
+	char* hit = memchr( thiz->buffer + from, thiz->delimiter, n );
+	size_t scanned = thiz->scanned + (hit ? hit - (thiz->buffer + from) : n);
+	if( scanned > thiz->maxRecord ) {
+	  thiz->length = thiz->scanned = 0;
+	  inputEnd( thiz, EMSGSIZE );
+	  return false;
+	}
+	thiz->scanned = scanned;
+	if( hit ) {
+	  *offset = thiz->start;
+	  *length = thiz->scanned;
+	  *consumed = thiz->scanned + 1;
+	  thiz->scanned = 0;
+	  return true;
+	}
+	todo -= n;
+	from = 0;
+  }
+  return false;
+}
+
+static bool inputNextPrefixed( ExecutiveInput* thiz, size_t* offset,
+							   size_t* length, size_t* consumed ) {
+  if( thiz->length < thiz->prefixSize )
+	return false;
+  uint32_t n = 0;
+  for( unsigned i = 0; i < thiz->prefixSize; i++ ) {
+	unsigned char b = thiz->buffer[(thiz->start + i) % thiz->capacity];
+	n = (n << 8) | b;
+  }
+  if( n > thiz->maxRecord ) {
+	inputEnd( thiz, EMSGSIZE );
+	return false;
+  }
+  if( thiz->length < thiz->prefixSize + n )
+	return false;
+  *offset = (thiz->start + thiz->prefixSize) % thiz->capacity;
+  *length = n;
+  *consumed = thiz->prefixSize + n;
+  return true;
+}
+
+static void inputDeliver( ExecutiveInput* thiz, size_t offset, size_t length ) {
+  if( offset + length > thiz->capacity ) {
+	// wrapped, copy the part at the ring's start into the slack
+	memcpy( thiz->buffer + thiz->capacity, thiz->buffer,
+			offset + length - thiz->capacity );
+  }
+  thiz->action( thiz, thiz->buffer + offset, length, thiz->env );
+}
+
+/*
+  At eof, any undelimited remainder is a final record.  Either way, we
+  unwatch and tell the action.
+*/
+static void inputEnd( ExecutiveInput* thiz, int error ) {
+  executiveUnwatchFd( thiz->executive, thiz->fd );
+  bool outer = !thiz->delivering;
+  thiz->delivering = true;
+  if( !error && !thiz->prefixSize && thiz->length > 0 &&
+	  thiz->length <= thiz->maxRecord ) {
+	size_t length = thiz->length;
+	thiz->length = thiz->scanned = 0;
+	inputDeliver( thiz, thiz->start, length );
+  }
+  if( !thiz->freed ) {
+	errno = error;
+	thiz->action( thiz, NULL, 0, thiz->env );
+  }
+  if( outer ) {
+	thiz->delivering = false;
+	if( thiz->freed )
+	  inputRelease( thiz );
+  }
+}
+
+static void inputRelease( ExecutiveInput* thiz ) {
+  executiveBufferPut( thiz->executive, thiz->buffer, thiz->size );
+  free( thiz );
+}
+
+// eof
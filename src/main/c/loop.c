@@ -0,0 +1,669 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/signalfd.h>
+#endif
+
+#include "executive/loop.h"
+#include "executive/parallel.h"
+#include "executive-private.h"
+
+/*
+  The watched fds, as the pollfd array handed straight to (p)poll, plus
+  parallel arrays of their Actions, for readability and writability.
+  Unwatching both just marks a slot dead (fd -1, which poll ignores),
+  since it may happen mid-dispatch.  Dead slots are compacted away
+  before the next wait.  slots maps an fd to its index, for O(1)
+  watch/unwatch.
+*/
+typedef struct ExecutiveWatch {
+  Action action;
+  void* env;
+} ExecutiveWatch;
+
+typedef struct ExecutiveLoop {
+  struct pollfd* fds;
+  ExecutiveWatch* watches;
+  ExecutiveWatch* writers;
+  size_t length;
+  size_t capacity;
+  size_t dead;
+
+  int* slots;
+  size_t slotsLength;
+
+  bool stopped;
+
+  // Head Events due within this are spun for, not blocked on. 0 = never
+  struct timeval spin;
+
+  // If set, due Events are fired in parallel, see parallel.h
+  ExecutiveWorkers* workers;
+
+  // Idle I/O buffers, see executiveBufferGet
+  struct PooledBuffer* buffers;
+  size_t buffersLength;
+
+  // Output queues with data not yet written, see output.c
+  struct ExecutiveOutput* dirty;
+
+  /*
+	Watched signals, all read from the one signalfd, so -1 until the
+	first is watched.  'blocked' are those we blocked ourselves, and so
+	unblock when done with.  signalWatches is indexed by signo.
+  */
+  int signalFd;
+  sigset_t signals;
+  sigset_t blocked;
+  ExecutiveWatch* signalWatches;
+} ExecutiveLoop;
+
+typedef struct PooledBuffer {
+  struct PooledBuffer* next;
+  size_t size;
+} PooledBuffer;
+
+// Idle buffers kept beyond this many are free'd
+#define BUFFER_POOL_MAX 16
+
+static ExecutiveLoop* executiveLoop( Executive* thiz );
+static int loopWatch( Executive* thiz, int fd, short events,
+					  Action action, void* env );
+static int loopUnwatch( Executive* thiz, int fd, short events );
+static int loopSlotsGrow( ExecutiveLoop* thiz, int fd );
+static void loopCompact( ExecutiveLoop* thiz );
+static int loopWait( ExecutiveLoop* thiz, struct timeval* wait );
+static int loopSpin( ExecutiveLoop* thiz, struct timeval* until );
+static void cpuRelax( unsigned n );
+static void loopFireDue( Executive* thiz, struct timeval* now );
+static void loopDispatch( Executive* thiz, size_t length );
+static void loopCall( Executive* thiz, ExecutiveWatch* w, struct timeval* now );
+#ifdef __linux__
+static void loopSignalReadable( Event* e, struct timeval* actualTime );
+#endif
+
+int executiveWatchFd( Executive* thiz, int fd, Action action, void* env ) {
+  return loopWatch( thiz, fd, POLLIN, action, env );
+}
+
+int executiveUnwatchFd( Executive* thiz, int fd ) {
+  return loopUnwatch( thiz, fd, POLLIN );
+}
+
+int executiveWatchFdWritable( Executive* thiz, int fd,
+							  Action action, void* env ) {
+  return loopWatch( thiz, fd, POLLOUT, action, env );
+}
+
+int executiveUnwatchFdWritable( Executive* thiz, int fd ) {
+  return loopUnwatch( thiz, fd, POLLOUT );
+}
+
+int executiveRunOnce( Executive* thiz ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( !loop )
+	return -1;
+  // before any wait, hand all output queued meanwhile to writev
+  if( loop->dirty )
+	executiveOutputFlushDirty( thiz );
+  if( loop->dead )
+	loopCompact( loop );
+
+  struct timeval now;
+  gettimeofday( &now, NULL );
+  struct timeval* head = executivePeek( thiz );
+  if( !timercmp( head, &now, > ) ) {
+	loopFireDue( thiz, &now );
+	return 1;
+  }
+
+  bool timed = executiveLength( thiz ) > 0;
+  if( !timed && loop->length == 0 )
+	return 0;
+
+  struct timeval wait;
+  timersub( head, &now, &wait );
+  size_t length = loop->length;
+  int ready;
+  if( timed && timerisset( &loop->spin ) ) {
+	/*
+	  Block until 'spin' short of the head time, so waking up early,
+	  never late. The remainder is then spun for, next time round.
+	*/
+	if( timercmp( &wait, &loop->spin, > ) ) {
+	  timersub( &wait, &loop->spin, &wait );
+	  ready = loopWait( loop, &wait );
+	} else {
+	  ready = loopSpin( loop, head );
+	}
+  } else {
+	ready = loopWait( loop, timed ? &wait : NULL );
+  }
+  if( ready == -1 )
+	return errno == EINTR ? 1 : -1;
+
+  if( ready == 0 ) {
+	gettimeofday( &now, NULL );
+	loopFireDue( thiz, &now );
+	return 1;
+  }
+
+  loopDispatch( thiz, length );
+  return 1;
+}
+
+int executiveRun( Executive* thiz ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( !loop )
+	return -1;
+  loop->stopped = false;
+  while( !loop->stopped ) {
+	int sc = executiveRunOnce( thiz );
+	if( sc < 1 )
+	  return sc;
+  }
+  return 0;
+}
+
+void executiveStop( Executive* thiz ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( loop )
+	loop->stopped = true;
+}
+
+size_t executiveRunSimulated( Executive* thiz, struct timeval* until ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( !loop )
+	return 0;
+  loop->stopped = false;
+  size_t result = 0;
+  while( !loop->stopped && executiveLength( thiz ) > 0 ) {
+	// a copy, the head Event is gone once fired
+	struct timeval now = *executivePeek( thiz );
+	if( timercmp( &now, until, > ) )
+	  break;
+	executiveFire( thiz, &now );
+	result++;
+  }
+  return result;
+}
+
+int executiveSetWorkers( Executive* thiz, ExecutiveWorkers* w ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( !loop )
+	return -1;
+  loop->workers = w;
+  return 0;
+}
+
+int executiveSetSpin( Executive* thiz, struct timeval* threshold ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( !loop )
+	return -1;
+  if( threshold )
+	loop->spin = *threshold;
+  else
+	timerclear( &loop->spin );
+  return 0;
+}
+
+#ifdef __linux__
+
+int executiveWatchSignal( Executive* thiz, int signo,
+						  Action action, void* env ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( !loop )
+	return -1;
+  if( signo <= 0 || signo >= NSIG ) {
+	errno = EINVAL;
+	return -1;
+  }
+  if( !loop->signalWatches ) {
+	loop->signalWatches = calloc( NSIG, sizeof( ExecutiveWatch ) );
+	if( !loop->signalWatches )
+	  return -1;
+  }
+
+  sigset_t one, old;
+  sigemptyset( &one );
+  sigaddset( &one, signo );
+  int sc = pthread_sigmask( SIG_BLOCK, &one, &old );
+  if( sc ) {
+	errno = sc;
+	return -1;
+  }
+  if( !sigismember( &old, signo ) )
+	sigaddset( &loop->blocked, signo );
+  sigaddset( &loop->signals, signo );
+
+  int fd = signalfd( loop->signalFd, &loop->signals,
+					 SFD_NONBLOCK | SFD_CLOEXEC );
+  if( fd < 0 )
+	return -1;
+  if( loop->signalFd < 0 ) {
+	loop->signalFd = fd;
+	if( executiveWatchFd( thiz, fd, loopSignalReadable, thiz ) )
+	  return -1;
+  }
+  loop->signalWatches[signo].action = action;
+  loop->signalWatches[signo].env = env;
+  return 0;
+}
+
+int executiveUnwatchSignal( Executive* thiz, int signo ) {
+  ExecutiveLoop* loop = thiz->loop;
+  if( !loop || loop->signalFd < 0 || signo <= 0 || signo >= NSIG ||
+	  !sigismember( &loop->signals, signo ) )
+	return -1;
+  sigdelset( &loop->signals, signo );
+  signalfd( loop->signalFd, &loop->signals, 0 );
+  loop->signalWatches[signo].action = NULL;
+  if( sigismember( &loop->blocked, signo ) ) {
+	sigset_t one;
+	sigemptyset( &one );
+	sigaddset( &one, signo );
+	pthread_sigmask( SIG_UNBLOCK, &one, NULL );
+	sigdelset( &loop->blocked, signo );
+  }
+  return 0;
+}
+
+#else
+
+int executiveWatchSignal( Executive* thiz, int signo,
+						  Action action, void* env ) {
+  (void)thiz;
+  (void)signo;
+  (void)action;
+  (void)env;
+  errno = ENOSYS;
+  return -1;
+}
+
+int executiveUnwatchSignal( Executive* thiz, int signo ) {
+  (void)thiz;
+  (void)signo;
+  errno = ENOSYS;
+  return -1;
+}
+
+#endif
+
+/**
+ * Our own threads (workers, watchdogs) run with all signals blocked,
+ * so that a watched signal, blocked only in the threads that were
+ * around to inherit that, is never delivered to one of ours instead.
+ */
+int executiveThreadCreate( pthread_t* thread, void* (*main)( void* ),
+						   void* arg ) {
+  sigset_t all, old;
+  sigfillset( &all );
+  int sc = pthread_sigmask( SIG_SETMASK, &all, &old );
+  if( sc )
+	return sc;
+  sc = pthread_create( thread, NULL, main, arg );
+  pthread_sigmask( SIG_SETMASK, &old, NULL );
+  return sc;
+}
+
+/**
+ * I/O buffers are recycled per Executive, so that fds coming and
+ * going (connections, say) do not cost a malloc/free of a large
+ * buffer each.
+ */
+void* executiveBufferGet( Executive* thiz, size_t size ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( loop ) {
+	for( PooledBuffer** pp = &loop->buffers; *pp; pp = &(*pp)->next ) {
+	  PooledBuffer* result = *pp;
+	  if( result->size == size ) {
+		*pp = result->next;
+		loop->buffersLength--;
+		return result;
+	  }
+	}
+  }
+  return malloc( size < sizeof( PooledBuffer ) ?
+				 sizeof( PooledBuffer ) : size );
+}
+
+void executiveBufferPut( Executive* thiz, void* buffer, size_t size ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( !loop || loop->buffersLength == BUFFER_POOL_MAX ) {
+	free( buffer );
+	return;
+  }
+  PooledBuffer* pb = (PooledBuffer*)buffer;
+  pb->size = size;
+  pb->next = loop->buffers;
+  loop->buffers = pb;
+  loop->buffersLength++;
+}
+
+struct ExecutiveOutput** executiveLoopDirty( Executive* thiz ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  return loop ? &loop->dirty : NULL;
+}
+
+void executiveLoopFree( Executive* thiz ) {
+  ExecutiveLoop* loop = thiz->loop;
+  if( !loop )
+	return;
+  if( loop->signalFd >= 0 ) {
+	close( loop->signalFd );
+	pthread_sigmask( SIG_UNBLOCK, &loop->blocked, NULL );
+  }
+  free( loop->signalWatches );
+  while( loop->buffers ) {
+	PooledBuffer* pb = loop->buffers;
+	loop->buffers = pb->next;
+	free( pb );
+  }
+  free( loop->fds );
+  free( loop->watches );
+  free( loop->writers );
+  free( loop->slots );
+  free( loop );
+  thiz->loop = NULL;
+}
+
+/******************************* STATICS **********************************/
+
+static ExecutiveLoop* executiveLoop( Executive* thiz ) {
+  if( thiz->loop )
+	return thiz->loop;
+  ExecutiveLoop* result = (ExecutiveLoop*)calloc( 1, sizeof( ExecutiveLoop ) );
+  if( !result )
+	return NULL;
+  result->signalFd = -1;
+  sigemptyset( &result->signals );
+  sigemptyset( &result->blocked );
+  thiz->loop = result;
+  return result;
+}
+
+/*
+  Add 'events' (POLLIN or POLLOUT) to fd's slot, making one if need be,
+  with the Action to call on that readiness.
+*/
+static int loopWatch( Executive* thiz, int fd, short events,
+					  Action action, void* env ) {
+  ExecutiveLoop* loop = executiveLoop( thiz );
+  if( !loop || fd < 0 || loopSlotsGrow( loop, fd ) )
+	return -1;
+  int slot = loop->slots[fd];
+  if( slot < 0 ) {
+	if( loop->length == loop->capacity ) {
+	  size_t capacity = loop->capacity ? 2 * loop->capacity : 8;
+	  struct pollfd* fds =
+		realloc( loop->fds, capacity * sizeof( struct pollfd ) );
+	  if( !fds )
+		return -1;
+	  loop->fds = fds;
+	  ExecutiveWatch* watches =
+		realloc( loop->watches, capacity * sizeof( ExecutiveWatch ) );
+	  if( !watches )
+		return -1;
+	  loop->watches = watches;
+	  ExecutiveWatch* writers =
+		realloc( loop->writers, capacity * sizeof( ExecutiveWatch ) );
+	  if( !writers )
+		return -1;
+	  loop->writers = writers;
+	  loop->capacity = capacity;
+	}
+	slot = loop->length++;
+	loop->slots[fd] = slot;
+	loop->fds[slot].fd = fd;
+	loop->fds[slot].events = 0;
+	loop->fds[slot].revents = 0;
+  }
+  loop->fds[slot].events |= events;
+  ExecutiveWatch* w = events == POLLOUT ? loop->writers : loop->watches;
+  w[slot].action = action;
+  w[slot].env = env;
+  return 0;
+}
+
+// The slot dies with the last of its events
+static int loopUnwatch( Executive* thiz, int fd, short events ) {
+  ExecutiveLoop* loop = thiz->loop;
+  if( !loop || fd < 0 || (size_t)fd >= loop->slotsLength ||
+	  loop->slots[fd] < 0 )
+	return -1;
+  struct pollfd* pfd = &loop->fds[loop->slots[fd]];
+  if( !(pfd->events & events) )
+	return -1;
+  pfd->events &= ~events;
+  if( pfd->events )
+	return 0;
+  pfd->fd = -1;
+  loop->slots[fd] = -1;
+  loop->dead++;
+  return 0;
+}
+
+static int loopSlotsGrow( ExecutiveLoop* thiz, int fd ) {
+  if( (size_t)fd < thiz->slotsLength )
+	return 0;
+  size_t length = thiz->slotsLength ? thiz->slotsLength : 64;
+  while( length <= (size_t)fd )
+	length *= 2;
+  int* slots = realloc( thiz->slots, length * sizeof( int ) );
+  if( !slots )
+	return -1;
+  for( size_t i = thiz->slotsLength; i < length; i++ )
+	slots[i] = -1;
+  thiz->slots = slots;
+  thiz->slotsLength = length;
+  return 0;
+}
+
+static void loopCompact( ExecutiveLoop* thiz ) {
+  size_t n = 0;
+  for( size_t i = 0; i < thiz->length; i++ ) {
+	if( thiz->fds[i].fd < 0 )
+	  continue;
+	thiz->fds[n] = thiz->fds[i];
+	thiz->watches[n] = thiz->watches[i];
+	thiz->writers[n] = thiz->writers[i];
+	thiz->slots[thiz->fds[n].fd] = n;
+	n++;
+  }
+  thiz->length = n;
+  thiz->dead = 0;
+}
+
+/*
+  Wait for fd readiness, for at most 'wait' (NULL for ever).  Plain
+  poll has only millisecond resolution, so we round up, to never wake
+  before the head Event is due.
+*/
+static int loopWait( ExecutiveLoop* thiz, struct timeval* wait ) {
+#ifdef __linux__
+  struct timespec ts;
+  if( wait ) {
+	ts.tv_sec = wait->tv_sec;
+	ts.tv_nsec = wait->tv_usec * 1000;
+  }
+  return ppoll( thiz->fds, thiz->length, wait ? &ts : NULL, NULL );
+#else
+  int timeout = -1;
+  if( wait ) {
+	long ms = wait->tv_sec * 1000L + (wait->tv_usec + 999) / 1000;
+	timeout = ms > INT_MAX ? INT_MAX : (int)ms;
+  }
+  return poll( thiz->fds, thiz->length, timeout );
+#endif
+}
+
+/*
+  Busy-poll the fds, and the clock, until either some fd is ready or
+  'until' arrives, so as to wake closer to it than a blocking wait
+  (subject to timer slack) can.  Between polls, the CPU is relaxed for
+  ever longer, up to a limit, to ease contention with a sibling
+  hyperthread.  Returns as per loopWait.
+*/
+static int loopSpin( ExecutiveLoop* thiz, struct timeval* until ) {
+  unsigned backoff = 1;
+  while( true ) {
+	int ready = poll( thiz->fds, thiz->length, 0 );
+	if( ready != 0 )
+	  return ready;
+	struct timeval now;
+	gettimeofday( &now, NULL );
+	if( !timercmp( until, &now, > ) )
+	  return 0;
+	cpuRelax( backoff );
+	if( backoff < 64 )
+	  backoff *= 2;
+  }
+}
+
+static void cpuRelax( unsigned n ) {
+  while( n-- > 0 ) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__( "yield" );
+#endif
+  }
+}
+
+/*
+  Fire those Events due by 'now'. Bounded by the count pending at the
+  outset, lest an Action forever re-adding itself for 'now' starve the
+  fds.
+*/
+static void loopFireDue( Executive* thiz, struct timeval* now ) {
+  ExecutiveWorkers* workers = thiz->loop->workers;
+  if( workers && executiveFireParallel( thiz, now, workers ) != EXECUTIVE_FULL )
+	return;
+  size_t n = executiveLength( thiz );
+  while( n-- > 0 && !timercmp( executivePeek( thiz ), now, > ) )
+	executiveFire( thiz, now );
+}
+
+/*
+  Only the first 'length' slots took part in the wait. Those added by
+  Actions during dispatch come after, with no revents. The arrays may
+  be realloc'd under us, so always index, never hold pointers.  Error
+  and hangup go to both Actions, readable first.
+*/
+static void loopDispatch( Executive* thiz, size_t length ) {
+  ExecutiveLoop* loop = thiz->loop;
+  struct timeval now;
+  gettimeofday( &now, NULL );
+  for( size_t i = 0; i < length; i++ ) {
+	int fd = loop->fds[i].fd;
+	short revents = loop->fds[i].revents;
+	if( fd < 0 || !revents )
+	  continue;
+	if( revents & POLLNVAL ) {
+	  loopUnwatch( thiz, fd, loop->fds[i].events );
+	  continue;
+	}
+	if( (loop->fds[i].events & POLLIN) && (revents & ~POLLOUT) ) {
+	  ExecutiveWatch w = loop->watches[i];
+	  loopCall( thiz, &w, &now );
+	}
+	// the read Action may well have unwatched fd
+	if( loop->fds[i].fd == fd && (loop->fds[i].events & POLLOUT) &&
+		(revents & ~POLLIN) ) {
+	  ExecutiveWatch w = loop->writers[i];
+	  loopCall( thiz, &w, &now );
+	}
+  }
+}
+
+// Deliver to an fd/signal watch's Action, via a transient Event
+static void loopCall( Executive* thiz, ExecutiveWatch* w, struct timeval* now ) {
+  Event e = { .executive = thiz, .scheduledTime = *now,
+			  .action = w->action, .env = w->env };
+  if( e.action )
+	(e.action)( &e, now );
+}
+
+#ifdef __linux__
+
+/*
+  Drain the signalfd, then call each signal's Action just once, in
+  order of first arrival, however many times (and however many
+  distinct signals) arrived since the last wakeup.
+*/
+static void loopSignalReadable( Event* e, struct timeval* actualTime ) {
+  Executive* thiz = (Executive*)executiveEventEnv( e );
+  ExecutiveLoop* loop = thiz->loop;
+
+  int arrived[NSIG];
+  size_t arrivedLength = 0;
+  sigset_t seen;
+  sigemptyset( &seen );
+
+  struct signalfd_siginfo infos[16];
+  while( true ) {
+	ssize_t nin = read( loop->signalFd, infos, sizeof( infos ) );
+	if( nin <= 0 )
+	  break;
+	for( size_t i = 0; i < nin / sizeof( infos[0] ); i++ ) {
+	  int signo = (int)infos[i].ssi_signo;
+	  if( signo <= 0 || signo >= NSIG || sigismember( &seen, signo ) )
+		continue;
+	  sigaddset( &seen, signo );
+	  arrived[arrivedLength++] = signo;
+	}
+  }
+
+  for( size_t i = 0; i < arrivedLength; i++ ) {
+	ExecutiveWatch w = loop->signalWatches[arrived[i]];
+	loopCall( thiz, &w, actualTime );
+  }
+}
+
+#endif
+
+// eof
@@ -0,0 +1,329 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "executive/output.h"
+#include "executive/loop.h"
+#include "executive-private.h"
+
+/*
+  A segment is a run of bytes to write: caller's data, by reference,
+  or a copy buffer of ours (chunkSize > 0), to which later small
+  writes append.  Segments form a ring of 'capacity', holding 'length'
+  from index 'head', of which the first 'offset' bytes are already
+  written.
+*/
+typedef struct OutputSegment {
+  const char* data;
+  size_t length;
+  size_t chunkSize;
+  void (*release)( void* arg );
+  void* arg;
+} OutputSegment;
+
+struct ExecutiveOutput {
+  Executive* executive;
+  int fd;
+
+  OutputSegment* segments;
+  size_t capacity;
+  size_t head;
+  size_t length;
+  size_t offset;
+  size_t pending;
+
+  // on the loop's dirty list, or else awaiting writability
+  bool dirty;
+  bool blocked;
+  ExecutiveOutput* next;
+
+  // sticky, once a write fails
+  int error;
+
+  void (*drained)( ExecutiveOutput* thiz, void* arg );
+  void* drainedArg;
+};
+
+// Copy buffers are this big, unless one write wants more
+#define OUTPUT_CHUNK 4096
+
+#ifdef IOV_MAX
+#define OUTPUT_IOV IOV_MAX
+#else
+#define OUTPUT_IOV 1024
+#endif
+
+static int outputAppend( ExecutiveOutput* thiz, OutputSegment* s );
+static void outputMarkDirty( ExecutiveOutput* thiz );
+static void outputWritable( Event* e, struct timeval* actualTime );
+static void outputConsume( ExecutiveOutput* thiz, size_t n );
+static void outputDiscard( ExecutiveOutput* thiz );
+static void outputRelease( ExecutiveOutput* thiz, OutputSegment* s );
+
+ExecutiveOutput* executiveOutputNew( Executive* e, int fd ) {
+  if( !executiveLoopDirty( e ) )
+	return NULL;
+  ExecutiveOutput* result = (ExecutiveOutput*)calloc
+	( 1, sizeof( ExecutiveOutput ) );
+  if( !result )
+	return NULL;
+  result->executive = e;
+  result->fd = fd;
+  return result;
+}
+
+int executiveOutputWrite( ExecutiveOutput* thiz,
+						  const void* data, size_t length ) {
+  if( thiz->error ) {
+	errno = thiz->error;
+	return -1;
+  }
+  if( length == 0 )
+	return 0;
+
+  // append to the last copy buffer, if room
+  if( thiz->length ) {
+	OutputSegment* tail =
+	  &thiz->segments[(thiz->head + thiz->length - 1) % thiz->capacity];
+	if( tail->chunkSize && tail->chunkSize - tail->length >= length ) {
+	  memcpy( (char*)tail->data + tail->length, data, length );
+	  tail->length += length;
+	  thiz->pending += length;
+	  outputMarkDirty( thiz );
+	  return 0;
+	}
+  }
+
+  size_t size = length > OUTPUT_CHUNK ? length : OUTPUT_CHUNK;
+  char* chunk = executiveBufferGet( thiz->executive, size );
+  if( !chunk )
+	return -1;
+  memcpy( chunk, data, length );
+  OutputSegment s = { .data = chunk, .length = length, .chunkSize = size };
+  if( outputAppend( thiz, &s ) ) {
+	executiveBufferPut( thiz->executive, chunk, size );
+	return -1;
+  }
+  return 0;
+}
+
+int executiveOutputWriteRef( ExecutiveOutput* thiz,
+							 const void* data, size_t length,
+							 void (*release)( void* arg ), void* arg ) {
+  OutputSegment s = { .data = data, .length = length,
+					  .release = release, .arg = arg };
+  if( length == 0 ) {
+	outputRelease( thiz, &s );
+	return 0;
+  }
+  if( thiz->error ) {
+	outputRelease( thiz, &s );
+	errno = thiz->error;
+	return -1;
+  }
+  if( outputAppend( thiz, &s ) ) {
+	outputRelease( thiz, &s );
+	return -1;
+  }
+  return 0;
+}
+
+/**
+ * One writev, of as many segments as it will take.  Whatever remains
+ * waits for writability, which, after a short write, is likely at
+ * once.
+ */
+ssize_t executiveOutputFlush( ExecutiveOutput* thiz ) {
+  if( thiz->error ) {
+	errno = thiz->error;
+	return -1;
+  }
+  if( thiz->length ) {
+	struct iovec iov[OUTPUT_IOV];
+	int n = 0;
+	for( size_t i = 0; i < thiz->length && n < OUTPUT_IOV; i++ ) {
+	  OutputSegment* s = &thiz->segments[(thiz->head + i) % thiz->capacity];
+	  size_t skip = i ? 0 : thiz->offset;
+	  iov[n].iov_base = (char*)s->data + skip;
+	  iov[n].iov_len = s->length - skip;
+	  n++;
+	}
+	ssize_t nout = writev( thiz->fd, iov, n );
+	if( nout > 0 ) {
+	  outputConsume( thiz, (size_t)nout );
+	} else if( nout < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+			   errno != EINTR ) {
+	  thiz->error = errno;
+	  outputDiscard( thiz );
+	  return -1;
+	}
+  }
+
+  bool blocked = thiz->length > 0;
+  if( blocked != thiz->blocked ) {
+	if( blocked )
+	  executiveWatchFdWritable( thiz->executive, thiz->fd,
+								outputWritable, thiz );
+	else
+	  executiveUnwatchFdWritable( thiz->executive, thiz->fd );
+	thiz->blocked = blocked;
+	// last, as it may free us
+	if( !blocked && thiz->drained ) {
+	  thiz->drained( thiz, thiz->drainedArg );
+	  return 0;
+	}
+  }
+  return (ssize_t)thiz->pending;
+}
+
+size_t executiveOutputPending( ExecutiveOutput* thiz ) {
+  return thiz->pending;
+}
+
+void executiveOutputSetDrained( ExecutiveOutput* thiz,
+								void (*drained)( ExecutiveOutput* out,
+												 void* arg ),
+								void* arg ) {
+  thiz->drained = drained;
+  thiz->drainedArg = arg;
+}
+
+void executiveOutputFree( ExecutiveOutput* thiz ) {
+  if( thiz->dirty ) {
+	ExecutiveOutput** pp = executiveLoopDirty( thiz->executive );
+	while( *pp != thiz )
+	  pp = &(*pp)->next;
+	*pp = thiz->next;
+  }
+  outputDiscard( thiz );
+  free( thiz->segments );
+  free( thiz );
+}
+
+int executiveOutputFd( ExecutiveOutput* thiz ) {
+  return thiz->fd;
+}
+
+/*
+  One at a time off the head, since a release callback may free, or
+  write to, some other queue.
+*/
+void executiveOutputFlushDirty( Executive* e ) {
+  ExecutiveOutput** head = executiveLoopDirty( e );
+  while( *head ) {
+	ExecutiveOutput* thiz = *head;
+	*head = thiz->next;
+	thiz->dirty = false;
+	executiveOutputFlush( thiz );
+  }
+}
+
+/******************************* STATICS **********************************/
+
+static int outputAppend( ExecutiveOutput* thiz, OutputSegment* s ) {
+  if( thiz->length == thiz->capacity ) {
+	size_t capacity = thiz->capacity ? 2 * thiz->capacity : 16;
+	OutputSegment* segments =
+	  malloc( capacity * sizeof( OutputSegment ) );
+	if( !segments )
+	  return -1;
+	for( size_t i = 0; i < thiz->length; i++ )
+	  segments[i] = thiz->segments[(thiz->head + i) % thiz->capacity];
+	free( thiz->segments );
+	thiz->segments = segments;
+	thiz->capacity = capacity;
+	thiz->head = 0;
+  }
+  thiz->segments[(thiz->head + thiz->length) % thiz->capacity] = *s;
+  thiz->length++;
+  thiz->pending += s->length;
+  outputMarkDirty( thiz );
+  return 0;
+}
+
+// A queue awaiting writability is flushed by that, not the loop
+static void outputMarkDirty( ExecutiveOutput* thiz ) {
+  if( thiz->dirty || thiz->blocked )
+	return;
+  ExecutiveOutput** head = executiveLoopDirty( thiz->executive );
+  thiz->next = *head;
+  *head = thiz;
+  thiz->dirty = true;
+}
+
+static void outputWritable( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  executiveOutputFlush( (ExecutiveOutput*)executiveEventEnv( e ) );
+}
+
+// n bytes were written: release the segments they complete
+static void outputConsume( ExecutiveOutput* thiz, size_t n ) {
+  thiz->pending -= n;
+  n += thiz->offset;
+  while( thiz->length ) {
+	OutputSegment* s = &thiz->segments[thiz->head];
+	if( n < s->length )
+	  break;
+	n -= s->length;
+	outputRelease( thiz, s );
+	thiz->head = (thiz->head + 1) % thiz->capacity;
+	thiz->length--;
+  }
+  thiz->offset = n;
+}
+
+static void outputDiscard( ExecutiveOutput* thiz ) {
+  for( size_t i = 0; i < thiz->length; i++ )
+	outputRelease( thiz, &thiz->segments[(thiz->head + i) % thiz->capacity] );
+  thiz->head = thiz->length = thiz->offset = thiz->pending = 0;
+  if( thiz->blocked ) {
+	executiveUnwatchFdWritable( thiz->executive, thiz->fd );
+	thiz->blocked = false;
+  }
+}
+
+static void outputRelease( ExecutiveOutput* thiz, OutputSegment* s ) {
+  if( s->chunkSize )
+	executiveBufferPut( thiz->executive, (void*)s->data, s->chunkSize );
+  else if( s->release )
+	s->release( s->arg );
+}
+
+// eof
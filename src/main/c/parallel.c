@@ -0,0 +1,264 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "executive/parallel.h"
+#include "executive-private.h"
+
+/*
+  A batch is formed, by the caller, in 'events': all due Events, in
+  scheduled order, grouped by worker (a counting sort on each Event's
+  worker index, so stable), worker i's share being events[first[i]]
+  to events[first[i+1]].  Workers wait on 'start' for the batch
+  generation to advance, the caller on 'done' for 'busy' to reach 0.
+*/
+typedef struct Worker {
+  struct ExecutiveWorkers* pool;
+  size_t index;
+  pthread_t thread;
+} Worker;
+
+struct ExecutiveWorkers {
+  size_t threads;
+  Worker* workers;
+  void* (*key)( Event* e );
+
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long generation;
+  size_t busy;
+  bool quit;
+
+  // The batch, see above
+  struct timeval now;
+  Event** events;
+  Event** unsorted;
+  size_t* owners;
+  size_t capacity;
+  size_t* first;
+  size_t* fill;
+
+  // Set as the Executive's mutex while a batch runs
+  pthread_mutex_t executiveLock;
+};
+
+static void* workerMain( void* arg );
+static size_t workerOf( ExecutiveWorkers* thiz, Event* e );
+static int batchReserve( ExecutiveWorkers* thiz, size_t n );
+
+ExecutiveWorkers* executiveWorkersNew( size_t threads,
+									   void* (*key)( Event* e ) ) {
+  if( threads == 0 ) {
+	errno = EINVAL;
+	return NULL;
+  }
+  ExecutiveWorkers* result = calloc( 1, sizeof( ExecutiveWorkers ) );
+  if( !result )
+	return NULL;
+  result->threads = threads;
+  result->key = key;
+  result->workers = calloc( threads, sizeof( Worker ) );
+  result->first = calloc( threads + 1, sizeof( size_t ) );
+  result->fill = calloc( threads, sizeof( size_t ) );
+  if( !result->workers || !result->first || !result->fill ) {
+	free( result->workers );
+	free( result->first );
+	free( result->fill );
+	free( result );
+	return NULL;
+  }
+  pthread_mutex_init( &result->lock, NULL );
+  pthread_cond_init( &result->start, NULL );
+  pthread_cond_init( &result->done, NULL );
+  pthread_mutex_init( &result->executiveLock, NULL );
+
+  for( size_t i = 0; i < threads; i++ ) {
+	Worker* w = &result->workers[i];
+	w->pool = result;
+	w->index = i;
+	int sc = executiveThreadCreate( &w->thread, workerMain, w );
+	if( sc ) {
+	  result->threads = i;
+	  executiveWorkersFree( result );
+	  errno = sc;
+	  return NULL;
+	}
+  }
+  return result;
+}
+
+void executiveWorkersFree( ExecutiveWorkers* thiz ) {
+  pthread_mutex_lock( &thiz->lock );
+  thiz->quit = true;
+  pthread_cond_broadcast( &thiz->start );
+  pthread_mutex_unlock( &thiz->lock );
+  for( size_t i = 0; i < thiz->threads; i++ )
+	pthread_join( thiz->workers[i].thread, NULL );
+
+  pthread_mutex_destroy( &thiz->lock );
+  pthread_cond_destroy( &thiz->start );
+  pthread_cond_destroy( &thiz->done );
+  pthread_mutex_destroy( &thiz->executiveLock );
+  free( thiz->events );
+  free( thiz->unsorted );
+  free( thiz->owners );
+  free( thiz->first );
+  free( thiz->fill );
+  free( thiz->workers );
+  free( thiz );
+}
+
+size_t executiveFireParallel( Executive* e, struct timeval* now,
+							  ExecutiveWorkers* thiz ) {
+  // bounded, as for the run loop, lest Actions re-adding for 'now' starve
+  size_t n = executiveLength( e );
+  if( batchReserve( thiz, n ) )
+	return EXECUTIVE_FULL;
+
+  // pop the due Events, noting each one's worker
+  size_t* counts = thiz->first + 1;
+  for( size_t i = 0; i < thiz->threads; i++ )
+	counts[i] = 0;
+  size_t length = 0;
+  Event* ev;
+  while( length < n && (ev = executivePop( e, now )) ) {
+	size_t owner = workerOf( thiz, ev );
+	thiz->unsorted[length] = ev;
+	thiz->owners[length] = owner;
+	counts[owner]++;
+	length++;
+  }
+  if( length == 0 )
+	return 0;
+
+  // counts to offsets, then a stable scatter into per-worker runs
+  thiz->first[0] = 0;
+  for( size_t i = 1; i <= thiz->threads; i++ )
+	thiz->first[i] += thiz->first[i-1];
+  for( size_t i = 0; i < thiz->threads; i++ )
+	thiz->fill[i] = thiz->first[i];
+  for( size_t i = 0; i < length; i++ )
+	thiz->events[thiz->fill[thiz->owners[i]]++] = thiz->unsorted[i];
+
+  // Actions may change e, or its tree, meanwhile, see executiveLock
+  Executive* root = e;
+  while( root->parent )
+	root = root->parent;
+  thiz->now = *now;
+  root->mutex = &thiz->executiveLock;
+
+  pthread_mutex_lock( &thiz->lock );
+  thiz->busy = thiz->threads;
+  thiz->generation++;
+  pthread_cond_broadcast( &thiz->start );
+  while( thiz->busy )
+	pthread_cond_wait( &thiz->done, &thiz->lock );
+  pthread_mutex_unlock( &thiz->lock );
+
+  root->mutex = NULL;
+  return length;
+}
+
+/******************************* STATICS **********************************/
+
+static void* workerMain( void* arg ) {
+  Worker* w = (Worker*)arg;
+  ExecutiveWorkers* thiz = w->pool;
+  unsigned long seen = 0;
+
+  pthread_mutex_lock( &thiz->lock );
+  while( true ) {
+	while( !thiz->quit && thiz->generation == seen )
+	  pthread_cond_wait( &thiz->start, &thiz->lock );
+	if( thiz->quit )
+	  break;
+	seen = thiz->generation;
+	pthread_mutex_unlock( &thiz->lock );
+
+	for( size_t i = thiz->first[w->index]; i < thiz->first[w->index+1]; i++ ) {
+	  Event* e = thiz->events[i];
+	  // as for executiveFire, caller-owned storage is not touched after
+	  bool external = e->external;
+	  if( e->action )
+		(e->action)( e, &thiz->now );
+	  if( !external ) {
+		pthread_mutex_lock( &thiz->executiveLock );
+		executiveEventFree( e );
+		pthread_mutex_unlock( &thiz->executiveLock );
+	  }
+	}
+
+	pthread_mutex_lock( &thiz->lock );
+	if( --thiz->busy == 0 )
+	  pthread_cond_signal( &thiz->done );
+  }
+  pthread_mutex_unlock( &thiz->lock );
+  return NULL;
+}
+
+// Fibonacci hashing of the key, spreading pointers (aligned) evenly
+static size_t workerOf( ExecutiveWorkers* thiz, Event* e ) {
+  void* key = thiz->key ? thiz->key( e ) : e->env;
+  uint64_t h = (uint64_t)(uintptr_t)key * UINT64_C(0x9E3779B97F4A7C15);
+  return (size_t)((h >> 32) % thiz->threads);
+}
+
+static int batchReserve( ExecutiveWorkers* thiz, size_t n ) {
+  if( n <= thiz->capacity )
+	return 0;
+  size_t capacity = thiz->capacity ? thiz->capacity : 64;
+  while( capacity < n )
+	capacity *= 2;
+  Event** events = realloc( thiz->events, capacity * sizeof( Event* ) );
+  if( !events )
+	return -1;
+  thiz->events = events;
+  Event** unsorted = realloc( thiz->unsorted, capacity * sizeof( Event* ) );
+  if( !unsorted )
+	return -1;
+  thiz->unsorted = unsorted;
+  size_t* owners = realloc( thiz->owners, capacity * sizeof( size_t ) );
+  if( !owners )
+	return -1;
+  thiz->owners = owners;
+  thiz->capacity = capacity;
+  return 0;
+}
+
+// eof
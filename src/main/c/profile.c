@@ -0,0 +1,235 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "executive/profile.h"
+#include "executive-private.h"
+
+/*
+  Figures per Action, in an open-addressed (linear probing) hash table
+  keyed by the Action pointer, kept at most half full.
+*/
+typedef struct ProfileEntry {
+  Action action;
+  ExecutiveProfileStats stats;
+} ProfileEntry;
+
+typedef struct ExecutiveProfile {
+  ProfileEntry* entries;
+  size_t capacity;
+  size_t length;
+} ExecutiveProfile;
+
+static ProfileEntry* profileEntry( ExecutiveProfile* thiz, Action a,
+								   bool add );
+static int profileGrow( ExecutiveProfile* thiz );
+static size_t actionHash( Action a, size_t capacity );
+static uint64_t nanos( struct timespec* from, struct timespec* to );
+static int profileCompare( const void* a, const void* b );
+static void profilePrintName( FILE* f, Action a );
+
+int executiveProfileStart( Executive* thiz ) {
+  executiveProfileStop( thiz );
+  ExecutiveProfile* p = calloc( 1, sizeof( ExecutiveProfile ) );
+  if( !p )
+	return -1;
+  thiz->profile = p;
+  return 0;
+}
+
+void executiveProfileStop( Executive* thiz ) {
+  ExecutiveProfile* p = thiz->profile;
+  if( !p )
+	return;
+  free( p->entries );
+  free( p );
+  thiz->profile = NULL;
+}
+
+bool executiveProfileGet( Executive* thiz, Action a,
+						  ExecutiveProfileStats* result ) {
+  ExecutiveProfile* p = thiz->profile;
+  ProfileEntry* entry = p ? profileEntry( p, a, false ) : NULL;
+  if( !entry )
+	return false;
+  *result = entry->stats;
+  return true;
+}
+
+void executiveProfileReport( Executive* thiz, FILE* f, size_t topN ) {
+  ExecutiveProfile* p = thiz->profile;
+  if( !p )
+	return;
+  ProfileEntry** sorted = malloc( (p->length ? p->length : 1) *
+								  sizeof( ProfileEntry* ) );
+  if( !sorted )
+	return;
+  size_t n = 0;
+  for( size_t i = 0; i < p->capacity; i++ )
+	if( p->entries[i].action )
+	  sorted[n++] = &p->entries[i];
+  qsort( sorted, n, sizeof( ProfileEntry* ), profileCompare );
+
+  fprintf( f, "%10s %12s %10s %12s %10s  %s\n", "calls", "cpu(us)",
+		   "max", "wall(us)", "max", "action" );
+  for( size_t i = 0; i < n && i < topN; i++ ) {
+	ExecutiveProfileStats* s = &sorted[i]->stats;
+	fprintf( f, "%10llu %12llu %10llu %12llu %10llu  ",
+			 (unsigned long long)s->calls,
+			 (unsigned long long)(s->cpuTotal / 1000),
+			 (unsigned long long)(s->cpuMax / 1000),
+			 (unsigned long long)(s->wallTotal / 1000),
+			 (unsigned long long)(s->wallMax / 1000) );
+	profilePrintName( f, sorted[i]->action );
+	fputc( '\n', f );
+  }
+  free( sorted );
+}
+
+/*
+  CPU time is that of this thread only, so excludes any time the
+  Action spent blocked, which wall time includes.
+*/
+void executiveProfileCall( Executive* thiz, Event* e,
+						   struct timeval* actualTime ) {
+  Action action = e->action;
+  struct timespec wall0, wall1, cpu0, cpu1;
+  clock_gettime( CLOCK_MONOTONIC, &wall0 );
+  clock_gettime( CLOCK_THREAD_CPUTIME_ID, &cpu0 );
+  (action)( e, actualTime );
+  clock_gettime( CLOCK_THREAD_CPUTIME_ID, &cpu1 );
+  clock_gettime( CLOCK_MONOTONIC, &wall1 );
+
+  // the Action may have stopped profiling, or we may be out of memory
+  ExecutiveProfile* p = thiz->profile;
+  ProfileEntry* entry = p ? profileEntry( p, action, true ) : NULL;
+  if( !entry )
+	return;
+  ExecutiveProfileStats* s = &entry->stats;
+  uint64_t wall = nanos( &wall0, &wall1 );
+  uint64_t cpu = nanos( &cpu0, &cpu1 );
+  s->calls++;
+  s->wallTotal += wall;
+  s->cpuTotal += cpu;
+  if( wall > s->wallMax )
+	s->wallMax = wall;
+  if( cpu > s->cpuMax )
+	s->cpuMax = cpu;
+}
+
+/******************************* STATICS **********************************/
+
+// a's entry, added if need be (and 'add'), else NULL
+static ProfileEntry* profileEntry( ExecutiveProfile* thiz, Action a,
+								   bool add ) {
+  if( thiz->capacity ) {
+	size_t i = actionHash( a, thiz->capacity );
+	for( ; thiz->entries[i].action; i = (i + 1) & (thiz->capacity - 1) )
+	  if( thiz->entries[i].action == a )
+		return &thiz->entries[i];
+  }
+  if( !add )
+	return NULL;
+  if( 2 * (thiz->length + 1) > thiz->capacity && profileGrow( thiz ) )
+	return NULL;
+  size_t i = actionHash( a, thiz->capacity );
+  while( thiz->entries[i].action )
+	i = (i + 1) & (thiz->capacity - 1);
+  thiz->entries[i].action = a;
+  thiz->length++;
+  return &thiz->entries[i];
+}
+
+static int profileGrow( ExecutiveProfile* thiz ) {
+  size_t capacity = thiz->capacity ? 2 * thiz->capacity : 32;
+  ProfileEntry* entries = calloc( capacity, sizeof( ProfileEntry ) );
+  if( !entries )
+	return -1;
+  for( size_t i = 0; i < thiz->capacity; i++ ) {
+	ProfileEntry* old = &thiz->entries[i];
+	if( !old->action )
+	  continue;
+	size_t j = actionHash( old->action, capacity );
+	while( entries[j].action )
+	  j = (j + 1) & (capacity - 1);
+	entries[j] = *old;
+  }
+  free( thiz->entries );
+  thiz->entries = entries;
+  thiz->capacity = capacity;
+  return 0;
+}
+
+static size_t actionHash( Action a, size_t capacity ) {
+  uint64_t h = (uint64_t)(uintptr_t)a * UINT64_C(0x9E3779B97F4A7C15);
+  return (size_t)(h >> 32) & (capacity - 1);
+}
+
+static uint64_t nanos( struct timespec* from, struct timespec* to ) {
+  int64_t result = (int64_t)(to->tv_sec - from->tv_sec) * 1000000000 +
+	(to->tv_nsec - from->tv_nsec);
+  return result > 0 ? (uint64_t)result : 0;
+}
+
+// Most CPU first
+static int profileCompare( const void* a, const void* b ) {
+  uint64_t ca = (*(ProfileEntry* const*)a)->stats.cpuTotal;
+  uint64_t cb = (*(ProfileEntry* const*)b)->stats.cpuTotal;
+  return ca < cb ? 1 : ca > cb ? -1 : 0;
+}
+
+static void profilePrintName( FILE* f, Action a ) {
+  void* addr = (void*)a;
+  Dl_info info;
+  if( !dladdr( addr, &info ) ) {
+	fprintf( f, "%p", addr );
+  } else if( info.dli_sname && info.dli_saddr == addr ) {
+	fputs( info.dli_sname, f );
+  } else {
+	const char* file = info.dli_fname ? info.dli_fname : "?";
+	const char* slash = strrchr( file, '/' );
+	fprintf( f, "%s+%#lx", slash ? slash + 1 : file,
+			 (unsigned long)((char*)addr - (char*)info.dli_fbase) );
+  }
+}
+
+// eof
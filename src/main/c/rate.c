@@ -0,0 +1,252 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "executive/rate.h"
+#include "executive-private.h"
+
+typedef struct Waiter {
+  struct Waiter* next;
+  Action action;
+  void* env;
+} Waiter;
+
+/*
+  Times in microseconds.  'tat' (theoretical arrival time) is when
+  the bucket would next be empty; a token is available if now is at
+  least 'tolerance', i.e. burst - 1 intervals, short of it.  The one
+  pending Event, if any, is in 'storage', with the limiter as its env.
+*/
+struct ExecutiveRateLimiter {
+  Executive* executive;
+  int64_t interval;
+  int64_t tolerance;
+  int64_t tat;
+
+  Waiter* head;
+  Waiter** tail;
+  size_t waiting;
+
+  bool armed;
+  bool firing;
+  bool freed;
+  bool denying;
+  ExecutiveEventStorage storage;
+};
+
+static bool rateTake( ExecutiveRateLimiter* thiz, int64_t now );
+static int rateArm( ExecutiveRateLimiter* thiz, int64_t now );
+static void rateWake( Event* e, struct timeval* actualTime );
+static void rateDeny( ExecutiveRateLimiter* thiz, Event* call,
+					  struct timeval* actualTime );
+static void rateDisarmed( void* env );
+static void rateRelease( ExecutiveRateLimiter* thiz );
+static int64_t usecs( struct timeval* tv );
+
+ExecutiveRateLimiter* executiveRateLimiterNew( Executive* e,
+											   struct timeval* interval,
+											   unsigned burst ) {
+  if( burst == 0 ) {
+	errno = EINVAL;
+	return NULL;
+  }
+  ExecutiveRateLimiter* result = malloc( sizeof( ExecutiveRateLimiter ) );
+  if( !result )
+	return NULL;
+  result->executive = e;
+  result->interval = usecs( interval );
+  result->tolerance = (int64_t)(burst - 1) * result->interval;
+  result->tat = INT64_MIN / 2;
+  result->head = NULL;
+  result->tail = &result->head;
+  result->waiting = 0;
+  result->armed = result->firing = result->freed = false;
+  result->denying = false;
+  return result;
+}
+
+void executiveRateLimiterFree( ExecutiveRateLimiter* thiz ) {
+  // mid-wake, rateWake frees us
+  if( thiz->firing ) {
+	thiz->freed = true;
+	return;
+  }
+  if( thiz->armed )
+	executiveEventCancel( (Event*)&thiz->storage );
+  rateRelease( thiz );
+}
+
+bool executiveRateLimiterTryAcquire( ExecutiveRateLimiter* thiz,
+									 struct timeval* now ) {
+  return !thiz->head && rateTake( thiz, usecs( now ) );
+}
+
+int executiveRateLimiterAcquireAsync( ExecutiveRateLimiter* thiz,
+									  struct timeval* now,
+									  Action action, void* env ) {
+  // being denied, so no more queueing
+  if( thiz->denying )
+	return -1;
+  Waiter* w = malloc( sizeof( Waiter ) );
+  if( !w )
+	return -1;
+  w->next = NULL;
+  w->action = action;
+  w->env = env;
+  *thiz->tail = w;
+  thiz->tail = &w->next;
+  thiz->waiting++;
+
+  // mid-wake, rateWake serves or re-arms for the new waiter
+  if( thiz->armed || thiz->firing )
+	return 0;
+  if( rateArm( thiz, usecs( now ) ) ) {
+	// so the only waiter, w
+	thiz->head = NULL;
+	thiz->tail = &thiz->head;
+	thiz->waiting = 0;
+	free( w );
+	return -1;
+  }
+  return 0;
+}
+
+size_t executiveRateLimiterWaiting( ExecutiveRateLimiter* thiz ) {
+  return thiz->waiting;
+}
+
+bool executiveRateLimiterDenied( ExecutiveRateLimiter* thiz ) {
+  return thiz->denying;
+}
+
+/******************************* STATICS **********************************/
+
+static bool rateTake( ExecutiveRateLimiter* thiz, int64_t now ) {
+  if( now < thiz->tat - thiz->tolerance )
+	return false;
+  thiz->tat = (thiz->tat > now ? thiz->tat : now) + thiz->interval;
+  return true;
+}
+
+// For when the head waiter's token is due, or now if it already is
+static int rateArm( ExecutiveRateLimiter* thiz, int64_t now ) {
+  int64_t at = thiz->tat - thiz->tolerance;
+  if( at < now )
+	at = now;
+  struct timeval tv = { .tv_sec = at / 1000000, .tv_usec = at % 1000000 };
+  if( executiveAddWithStorage( thiz->executive, &thiz->storage, &tv,
+							   rateWake, thiz ) == EXECUTIVE_FULL )
+	return -1;
+  ((Event*)&thiz->storage)->envFree = rateDisarmed;
+  thiz->armed = true;
+  return 0;
+}
+
+/*
+  Grant tokens to waiters, in turn, for as long as there are tokens,
+  each waiter's Action called via an Event bearing its env. Then wait
+  for the next token, if anyone is still waiting, else, if we cannot,
+  deny them.
+*/
+static void rateWake( Event* e, struct timeval* actualTime ) {
+  ExecutiveRateLimiter* thiz = (ExecutiveRateLimiter*)e->env;
+  // which may have been migrated since armed
+  thiz->executive = e->executive;
+  thiz->armed = false;
+  thiz->firing = true;
+
+  int64_t now = usecs( actualTime );
+  Event grant = *e;
+  grant.envFree = NULL;
+  while( thiz->head && !thiz->freed && rateTake( thiz, now ) ) {
+	Waiter* w = thiz->head;
+	thiz->head = w->next;
+	if( !thiz->head )
+	  thiz->tail = &thiz->head;
+	thiz->waiting--;
+	grant.action = w->action;
+	grant.env = w->env;
+	free( w );
+	if( grant.action )
+	  (grant.action)( &grant, actualTime );
+  }
+  if( thiz->head && !thiz->freed && rateArm( thiz, now ) )
+	rateDeny( thiz, &grant, actualTime );
+  thiz->firing = false;
+
+  if( thiz->freed )
+	rateRelease( thiz );
+}
+
+// The Executive is full, so each waiter is called now, but denied
+static void rateDeny( ExecutiveRateLimiter* thiz, Event* call,
+					  struct timeval* actualTime ) {
+  thiz->denying = true;
+  while( thiz->head && !thiz->freed ) {
+	Waiter* w = thiz->head;
+	thiz->head = w->next;
+	if( !thiz->head )
+	  thiz->tail = &thiz->head;
+	thiz->waiting--;
+	call->action = w->action;
+	call->env = w->env;
+	free( w );
+	if( call->action )
+	  (call->action)( call, actualTime );
+  }
+  thiz->denying = false;
+}
+
+// Our Event was discarded, the Executive cleared or freed
+static void rateDisarmed( void* env ) {
+  ((ExecutiveRateLimiter*)env)->armed = false;
+}
+
+static void rateRelease( ExecutiveRateLimiter* thiz ) {
+  while( thiz->head ) {
+	Waiter* w = thiz->head;
+	thiz->head = w->next;
+	free( w );
+  }
+  free( thiz );
+}
+
+static int64_t usecs( struct timeval* tv ) {
+  return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+// eof
@@ -0,0 +1,315 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "executive/schedule.h"
+#include "executive-private.h"
+
+/*
+  A compiled spec: one bit per allowed value of each field.  Days of
+  week are 0-6, a 7 in the spec setting bit 0.  The 'Any' flags note a
+  day field starting '*', even with a step, for cron's either-day rule.
+*/
+typedef struct Matcher {
+  uint64_t minutes;
+  uint32_t hours;
+  uint32_t days;
+  uint16_t months;
+  uint8_t weekdays;
+  bool daysAny;
+  bool weekdaysAny;
+} Matcher;
+
+/*
+  The one pending Event is in 'storage'.  The schedule is that Event's
+  env, and its envFree, so is free'd with the Event should the
+  Executive be cleared or freed.
+*/
+struct ExecutiveSchedule {
+  Executive* executive;
+  Matcher matcher;
+  Action action;
+  void* env;
+  bool firing;
+  bool cancelled;
+  ExecutiveEventStorage storage;
+};
+
+// Searches for a next occurrence give up beyond this, in days
+#define SEARCH_DAYS (5 * 366)
+
+static const struct {
+  const char* name;
+  const char* spec;
+} shorthands[] = {
+  { "@yearly", "0 0 1 1 *" },
+  { "@annually", "0 0 1 1 *" },
+  { "@monthly", "0 0 1 * *" },
+  { "@weekly", "0 0 * * 0" },
+  { "@daily", "0 0 * * *" },
+  { "@midnight", "0 0 * * *" },
+  { "@hourly", "0 * * * *" },
+};
+
+static int matcherCompile( Matcher* m, const char* spec );
+static const char* fieldParse( const char* s, int lo, int hi,
+							   uint64_t* bits, bool* any );
+static bool matchesDay( Matcher* m, struct tm* tm );
+static void scheduleAction( Event* e, struct timeval* actualTime );
+static int scheduleArm( ExecutiveSchedule* s, struct timeval* after );
+
+ExecutiveSchedule* executiveAddSchedule( Executive* thiz,
+										 const char* cronSpec,
+										 struct timeval* now,
+										 Action action, void* env ) {
+  ExecutiveSchedule* result = malloc( sizeof( ExecutiveSchedule ) );
+  if( !result )
+	return NULL;
+  if( matcherCompile( &result->matcher, cronSpec ) ) {
+	free( result );
+	errno = EINVAL;
+	return NULL;
+  }
+  result->executive = thiz;
+  result->action = action;
+  result->env = env;
+  result->firing = result->cancelled = false;
+
+  if( scheduleArm( result, now ) ) {
+	free( result );
+	return NULL;
+  }
+  return result;
+}
+
+void executiveScheduleCancel( ExecutiveSchedule* thiz ) {
+  // mid-action, our Event is not pending, scheduleAction frees us
+  if( thiz->firing ) {
+	thiz->cancelled = true;
+	return;
+  }
+  executiveEventCancel( (Event*)&thiz->storage );
+}
+
+bool executiveScheduleNext( ExecutiveSchedule* thiz, struct timeval* after,
+							struct timeval* result ) {
+  Matcher* m = &thiz->matcher;
+
+  /*
+	The walk is in wall-clock time, normalized as if UTC so that no
+	DST change moves it, from the minute after 'after'.  Only a match
+	is converted to a real time, one in a skipped hour then landing an
+	hour later.
+  */
+  time_t t = after->tv_sec;
+  struct tm tm;
+  localtime_r( &t, &tm );
+  tm.tm_sec = 0;
+  tm.tm_min++;
+  if( timegm( &tm ) == (time_t)-1 )
+	return false;
+
+  for( int days = 0; days < SEARCH_DAYS; ) {
+	if( !(m->months & (1u << (tm.tm_mon + 1))) ) {
+	  tm.tm_mon++;
+	  tm.tm_mday = 1;
+	  tm.tm_hour = tm.tm_min = 0;
+	  days += 28;
+	} else if( !matchesDay( m, &tm ) ) {
+	  tm.tm_mday++;
+	  tm.tm_hour = tm.tm_min = 0;
+	  days++;
+	} else if( !(m->hours & (1u << tm.tm_hour)) ) {
+	  tm.tm_hour++;
+	  tm.tm_min = 0;
+	} else if( !(m->minutes & (UINT64_C(1) << tm.tm_min)) ) {
+	  tm.tm_min++;
+	} else {
+	  struct tm local = tm;
+	  local.tm_isdst = -1;
+	  t = mktime( &local );
+	  if( t == (time_t)-1 )
+		return false;
+	  if( t > after->tv_sec ) {
+		result->tv_sec = t;
+		result->tv_usec = 0;
+		return true;
+	  }
+	  // a repeated hour, its wall time already passed once
+	  tm.tm_min++;
+	}
+	// normalize, e.g. 31 Apr to 1 May, hour 24 to next day
+	if( timegm( &tm ) == (time_t)-1 )
+	  return false;
+  }
+  return false;
+}
+
+/******************************* STATICS **********************************/
+
+static int matcherCompile( Matcher* m, const char* spec ) {
+  for( size_t i = 0; i < sizeof( shorthands ) / sizeof( shorthands[0] ); i++ )
+	if( strcmp( spec, shorthands[i].name ) == 0 )
+	  spec = shorthands[i].spec;
+
+  uint64_t bits[5];
+  bool any[5];
+  static const int lo[5] = { 0, 0, 1, 1, 0 };
+  static const int hi[5] = { 59, 23, 31, 12, 7 };
+  for( int i = 0; i < 5; i++ ) {
+	while( isspace( (unsigned char)*spec ) )
+	  spec++;
+	spec = fieldParse( spec, lo[i], hi[i], &bits[i], &any[i] );
+	if( !spec || !bits[i] )
+	  return -1;
+  }
+  while( isspace( (unsigned char)*spec ) )
+	spec++;
+  if( *spec )
+	return -1;
+
+  m->minutes = bits[0];
+  m->hours = (uint32_t)bits[1];
+  m->days = (uint32_t)bits[2];
+  m->months = (uint16_t)bits[3];
+  m->weekdays = (uint8_t)((bits[4] | bits[4] >> 7) & 0x7f);
+  m->daysAny = any[2];
+  m->weekdaysAny = any[4];
+  return 0;
+}
+
+static const char* numberParse( const char* s, int* result ) {
+  if( !isdigit( (unsigned char)*s ) )
+	return NULL;
+  *result = 0;
+  while( isdigit( (unsigned char)*s ) && *result < 1000 )
+	*result = *result * 10 + (*s++ - '0');
+  return s;
+}
+
+// One field, up to the next space (or end), so "1-5,10-20/2" etc
+static const char* fieldParse( const char* s, int lo, int hi,
+							   uint64_t* bits, bool* any ) {
+  *bits = 0;
+  *any = *s == '*';
+  while( true ) {
+	int from, to, step = 1;
+	if( *s == '*' ) {
+	  from = lo;
+	  to = hi;
+	  s++;
+	} else {
+	  if( !(s = numberParse( s, &from )) )
+		return NULL;
+	  to = from;
+	  if( *s == '-' && !(s = numberParse( s + 1, &to )) )
+		return NULL;
+	}
+	if( *s == '/' ) {
+	  if( !(s = numberParse( s + 1, &step )) || step == 0 )
+		return NULL;
+	  // as cron does, 'n/step' means n to the max
+	  if( from == to )
+		to = hi;
+	}
+	if( from < lo || to > hi || from > to )
+	  return NULL;
+	for( int v = from; v <= to; v += step )
+	  *bits |= UINT64_C(1) << v;
+	if( *s != ',' )
+	  break;
+	s++;
+  }
+  if( *s && !isspace( (unsigned char)*s ) )
+	return NULL;
+  return s;
+}
+
+static bool matchesDay( Matcher* m, struct tm* tm ) {
+  bool day = m->days & (1u << tm->tm_mday);
+  bool weekday = m->weekdays & (1u << tm->tm_wday);
+  if( m->daysAny || m->weekdaysAny )
+	return day && weekday;
+  return day || weekday;
+}
+
+static void scheduleFree( void* env ) {
+  free( env );
+}
+
+static int scheduleArm( ExecutiveSchedule* thiz, struct timeval* after ) {
+  struct timeval next;
+  if( !executiveScheduleNext( thiz, after, &next ) )
+	return -1;
+  Event* e = (Event*)&thiz->storage;
+  if( executiveAddWithStorage( thiz->executive, &thiz->storage, &next,
+							   scheduleAction, thiz ) == EXECUTIVE_FULL )
+	return -1;
+  e->envFree = scheduleFree;
+  return 0;
+}
+
+/*
+  Hand the occurrence to the user's action, as an Event bearing their
+  env, then arm the next occurrence, skipping any missed meanwhile
+  (the action ran late, or took a while).
+*/
+static void scheduleAction( Event* e, struct timeval* actualTime ) {
+  ExecutiveSchedule* thiz = (ExecutiveSchedule*)e->env;
+  struct timeval scheduled = e->scheduledTime;
+  // which may have been migrated since armed
+  thiz->executive = e->executive;
+
+  Event occurrence = *e;
+  occurrence.env = thiz->env;
+  occurrence.envFree = NULL;
+  thiz->firing = true;
+  if( thiz->action )
+	(thiz->action)( &occurrence, actualTime );
+  thiz->firing = false;
+
+  struct timeval* after = &scheduled;
+  if( timercmp( actualTime, after, > ) )
+	after = actualTime;
+  if( thiz->cancelled || scheduleArm( thiz, after ) )
+	free( thiz );
+}
+
+// eof
@@ -0,0 +1,529 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "executive/shared.h"
+#include "executive-private.h"
+
+#ifdef __linux__
+
+/*
+  The region: this header, then 'capacity' slots of 'slotSize' bytes,
+  each a SharedEvent followed by its env.  Links are slot indices,
+  NIL for none.  Pending Events form a list in time order, from head
+  to tail, free slots a stack.  Times are microseconds.
+*/
+#define NIL UINT32_MAX
+
+// 'EXEC', set once the region is ready for use
+#define SHARED_MAGIC 0x45584543
+
+typedef struct SharedRegion {
+  uint32_t magic;
+  uint32_t capacity;
+  uint32_t envSize;
+  uint32_t slotSize;
+  pthread_mutex_t mutex;
+
+  // bumped, and a waiter woken, whenever an Event becomes the head
+  uint32_t futex;
+
+  uint32_t length;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t freeSlots;
+} SharedRegion;
+
+/*
+  'generation' is bumped as the slot is freed, so that ids (slot index
+  plus generation) of Events gone are told apart from current ones.
+*/
+typedef struct SharedEvent {
+  int64_t time;
+  uint32_t prev;
+  uint32_t next;
+  uint32_t generation;
+  uint32_t kind;
+  uint32_t envSize;
+  bool used;
+} SharedEvent;
+
+#define ALIGNED(n) \
+  (((n) + _Alignof( max_align_t ) - 1) & ~(_Alignof( max_align_t ) - 1))
+
+#define SLOTS_OFFSET ALIGNED( sizeof( SharedRegion ) )
+
+#define ENV_OFFSET ALIGNED( sizeof( SharedEvent ) )
+
+struct ExecutiveShared {
+  SharedRegion* region;
+  size_t size;
+  Action actions[EXECUTIVE_SHARED_KINDS];
+
+  // this process's copy of the env of the Event being fired
+  void* env;
+};
+
+static ExecutiveShared* sharedMap( int fd, size_t size );
+static SharedEvent* sharedSlot( SharedRegion* r, uint32_t i );
+static int sharedLock( SharedRegion* r );
+static void sharedInsert( SharedRegion* r, uint32_t i );
+static void sharedRemove( SharedRegion* r, uint32_t i );
+static int sharedFireDue( ExecutiveShared* thiz );
+static int64_t usecs( struct timeval* tv );
+static int futexWait( uint32_t* addr, uint32_t value, int64_t usecs );
+static void futexWake( uint32_t* addr );
+
+ExecutiveShared* executiveSharedCreate( const char* name, size_t capacity,
+										size_t envSize ) {
+  if( capacity == 0 || capacity >= NIL || envSize > UINT32_MAX / 2 ) {
+	errno = EINVAL;
+	return NULL;
+  }
+  size_t slotSize = ALIGNED( ENV_OFFSET + envSize );
+  size_t size = SLOTS_OFFSET + capacity * slotSize;
+
+  int fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+  if( fd < 0 )
+	return NULL;
+  if( ftruncate( fd, (off_t)size ) ) {
+	int error = errno;
+	close( fd );
+	shm_unlink( name );
+	errno = error;
+	return NULL;
+  }
+  ExecutiveShared* result = sharedMap( fd, size );
+  close( fd );
+  if( !result ) {
+	shm_unlink( name );
+	return NULL;
+  }
+
+  SharedRegion* r = result->region;
+  r->capacity = (uint32_t)capacity;
+  r->envSize = (uint32_t)envSize;
+  r->slotSize = (uint32_t)slotSize;
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init( &attr );
+  pthread_mutexattr_setpshared( &attr, PTHREAD_PROCESS_SHARED );
+  pthread_mutexattr_setrobust( &attr, PTHREAD_MUTEX_ROBUST );
+  pthread_mutex_init( &r->mutex, &attr );
+  pthread_mutexattr_destroy( &attr );
+  r->futex = 0;
+  r->length = 0;
+  r->head = r->tail = NIL;
+  r->freeSlots = NIL;
+  for( uint32_t i = r->capacity; i-- > 0; ) {
+	SharedEvent* e = sharedSlot( r, i );
+	e->generation = 1;
+	e->used = false;
+	e->next = r->freeSlots;
+	r->freeSlots = i;
+  }
+  result->env = malloc( envSize ? envSize : 1 );
+  if( !result->env ) {
+	executiveSharedClose( result );
+	shm_unlink( name );
+	return NULL;
+  }
+  __atomic_store_n( &r->magic, SHARED_MAGIC, __ATOMIC_RELEASE );
+  return result;
+}
+
+ExecutiveShared* executiveSharedOpen( const char* name ) {
+  int fd = shm_open( name, O_RDWR, 0 );
+  if( fd < 0 )
+	return NULL;
+  struct stat st;
+  ExecutiveShared* result = NULL;
+  if( fstat( fd, &st ) == 0 && (size_t)st.st_size >= SLOTS_OFFSET )
+	result = sharedMap( fd, (size_t)st.st_size );
+  else
+	errno = EINVAL;
+  close( fd );
+  if( !result )
+	return NULL;
+
+  SharedRegion* r = result->region;
+  if( __atomic_load_n( &r->magic, __ATOMIC_ACQUIRE ) != SHARED_MAGIC ||
+	  SLOTS_OFFSET + (size_t)r->capacity * r->slotSize > result->size ) {
+	executiveSharedClose( result );
+	errno = EINVAL;
+	return NULL;
+  }
+  result->env = malloc( r->envSize ? r->envSize : 1 );
+  if( !result->env ) {
+	executiveSharedClose( result );
+	return NULL;
+  }
+  return result;
+}
+
+void executiveSharedClose( ExecutiveShared* thiz ) {
+  munmap( thiz->region, thiz->size );
+  free( thiz->env );
+  free( thiz );
+}
+
+int executiveSharedUnlink( const char* name ) {
+  return shm_unlink( name );
+}
+
+ExecutiveSharedId executiveSharedAdd( ExecutiveShared* thiz,
+									  struct timeval* scheduledTime,
+									  unsigned kind,
+									  const void* env, size_t envSize ) {
+  SharedRegion* r = thiz->region;
+  if( kind >= EXECUTIVE_SHARED_KINDS || envSize > r->envSize ||
+	  sharedLock( r ) )
+	return 0;
+  ExecutiveSharedId result = 0;
+  uint32_t i = r->freeSlots;
+  if( i != NIL ) {
+	SharedEvent* e = sharedSlot( r, i );
+	r->freeSlots = e->next;
+	e->time = usecs( scheduledTime );
+	e->kind = kind;
+	e->envSize = (uint32_t)envSize;
+	e->used = true;
+	if( envSize )
+	  memcpy( (char*)e + ENV_OFFSET, env, envSize );
+	sharedInsert( r, i );
+	result = (uint64_t)e->generation << 32 | i;
+	// an earlier Event than any waiter knew of, so wake one
+	if( r->head == i ) {
+	  r->futex++;
+	  futexWake( &r->futex );
+	}
+  }
+  pthread_mutex_unlock( &r->mutex );
+  return result;
+}
+
+int executiveSharedCancel( ExecutiveShared* thiz, ExecutiveSharedId id ) {
+  SharedRegion* r = thiz->region;
+  uint32_t i = (uint32_t)id;
+  uint32_t generation = (uint32_t)(id >> 32);
+  if( i >= r->capacity || sharedLock( r ) )
+	return -1;
+  int result = -1;
+  SharedEvent* e = sharedSlot( r, i );
+  if( e->used && e->generation == generation ) {
+	sharedRemove( r, i );
+	result = 0;
+  }
+  pthread_mutex_unlock( &r->mutex );
+  return result;
+}
+
+size_t executiveSharedLength( ExecutiveShared* thiz ) {
+  return __atomic_load_n( &thiz->region->length, __ATOMIC_RELAXED );
+}
+
+int executiveSharedSetAction( ExecutiveShared* thiz, unsigned kind,
+							  Action action ) {
+  if( kind >= EXECUTIVE_SHARED_KINDS )
+	return -1;
+  thiz->actions[kind] = action;
+  return 0;
+}
+
+/*
+  The futex value is read under the mutex, so an Event added between
+  our unlocking and waiting changes it, and the wait returns at once.
+
+  A new head wakes just one waiter, not all, lest they all then fight
+  over the mutex.  That one waits on, for the new head, rather than
+  returning.  Any process leaving with Events still pending passes a
+  wake on, so that, if any other is waiting, some process is waiting
+  for the head.
+*/
+int executiveSharedRunOnce( ExecutiveShared* thiz, struct timeval* timeout ) {
+  SharedRegion* r = thiz->region;
+  int64_t deadline = -1;
+  if( timeout ) {
+	struct timeval now;
+	gettimeofday( &now, NULL );
+	deadline = usecs( &now ) + usecs( timeout );
+  }
+
+  int result = sharedFireDue( thiz );
+  while( result == 0 ) {
+	if( sharedLock( r ) )
+	  return -1;
+	uint32_t value = r->futex;
+	struct timeval now;
+	gettimeofday( &now, NULL );
+	int64_t wait = -1;
+	if( r->head != NIL ) {
+	  wait = sharedSlot( r, r->head )->time - usecs( &now );
+	  if( wait < 0 )
+		wait = 0;
+	}
+	pthread_mutex_unlock( &r->mutex );
+	if( deadline >= 0 ) {
+	  int64_t left = deadline - usecs( &now );
+	  if( left < 0 )
+		break;
+	  if( wait < 0 || left < wait )
+		wait = left;
+	}
+
+	// a signal, for the caller to see to
+	bool interrupted = futexWait( &r->futex, value, wait ) && errno == EINTR;
+	result = sharedFireDue( thiz );
+	if( interrupted )
+	  break;
+  }
+
+  if( executiveSharedLength( thiz ) )
+	futexWake( &r->futex );
+  return result;
+}
+
+/******************************* STATICS **********************************/
+
+static ExecutiveShared* sharedMap( int fd, size_t size ) {
+  ExecutiveShared* result = calloc( 1, sizeof( ExecutiveShared ) );
+  if( !result )
+	return NULL;
+  void* base = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  if( base == MAP_FAILED ) {
+	free( result );
+	return NULL;
+  }
+  result->region = (SharedRegion*)base;
+  result->size = size;
+  return result;
+}
+
+static SharedEvent* sharedSlot( SharedRegion* r, uint32_t i ) {
+  return (SharedEvent*)((char*)r + SLOTS_OFFSET + (size_t)i * r->slotSize);
+}
+
+/*
+  A process dying mid-change may leave the list inconsistent, but
+  changes are few instructions, so we carry on regardless rather than
+  leave the mutex unusable.
+*/
+static int sharedLock( SharedRegion* r ) {
+  int sc = pthread_mutex_lock( &r->mutex );
+  if( sc == EOWNERDEAD )
+	sc = pthread_mutex_consistent( &r->mutex );
+  return sc;
+}
+
+// As the intrusive store, scanning back from the tail, so FIFO on ties
+static void sharedInsert( SharedRegion* r, uint32_t i ) {
+  SharedEvent* e = sharedSlot( r, i );
+  uint32_t pos = r->tail;
+  while( pos != NIL && sharedSlot( r, pos )->time > e->time )
+	pos = sharedSlot( r, pos )->prev;
+  e->prev = pos;
+  e->next = pos == NIL ? r->head : sharedSlot( r, pos )->next;
+  if( e->next == NIL )
+	r->tail = i;
+  else
+	sharedSlot( r, e->next )->prev = i;
+  if( pos == NIL )
+	r->head = i;
+  else
+	sharedSlot( r, pos )->next = i;
+  r->length++;
+}
+
+// Unlink slot i, and free it
+static void sharedRemove( SharedRegion* r, uint32_t i ) {
+  SharedEvent* e = sharedSlot( r, i );
+  if( e->prev == NIL )
+	r->head = e->next;
+  else
+	sharedSlot( r, e->prev )->next = e->next;
+  if( e->next == NIL )
+	r->tail = e->prev;
+  else
+	sharedSlot( r, e->next )->prev = e->prev;
+  r->length--;
+  e->used = false;
+  if( ++e->generation == 0 )
+	e->generation = 1;
+  e->next = r->freeSlots;
+  r->freeSlots = i;
+}
+
+/*
+  Take due Events one at a time, copying each out before calling its
+  Action, unlocked, so that it may add or cancel.  Bounded by the count
+  pending at the outset, as per the run loop.
+*/
+static int sharedFireDue( ExecutiveShared* thiz ) {
+  SharedRegion* r = thiz->region;
+  struct timeval now;
+  gettimeofday( &now, NULL );
+  int64_t t = usecs( &now );
+
+  int result = 0;
+  size_t n = executiveSharedLength( thiz );
+  while( n-- > 0 ) {
+	if( sharedLock( r ) )
+	  return -1;
+	uint32_t i = r->head;
+	if( i == NIL || sharedSlot( r, i )->time > t ) {
+	  pthread_mutex_unlock( &r->mutex );
+	  break;
+	}
+	SharedEvent* e = sharedSlot( r, i );
+	int64_t time = e->time;
+	unsigned kind = e->kind;
+	memcpy( thiz->env, (char*)e + ENV_OFFSET, e->envSize );
+	sharedRemove( r, i );
+	pthread_mutex_unlock( &r->mutex );
+
+	Event event = { .executive = NULL,
+					.scheduledTime = { .tv_sec = time / 1000000,
+									   .tv_usec = time % 1000000 },
+					.action = thiz->actions[kind], .env = thiz->env };
+	if( event.action )
+	  (event.action)( &event, &now );
+	result++;
+  }
+  return result;
+}
+
+static int64_t usecs( struct timeval* tv ) {
+  return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+// Not FUTEX_PRIVATE, the word being shared between processes
+static int futexWait( uint32_t* addr, uint32_t value, int64_t usecs ) {
+  struct timespec ts;
+  if( usecs >= 0 ) {
+	ts.tv_sec = usecs / 1000000;
+	ts.tv_nsec = (usecs % 1000000) * 1000;
+  }
+  return (int)syscall( SYS_futex, addr, FUTEX_WAIT, value,
+					   usecs >= 0 ? &ts : NULL, NULL, 0 );
+}
+
+// Just the one waiter
+static void futexWake( uint32_t* addr ) {
+  syscall( SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0 );
+}
+
+#else
+
+ExecutiveShared* executiveSharedCreate( const char* name, size_t capacity,
+										size_t envSize ) {
+  (void)name;
+  (void)capacity;
+  (void)envSize;
+  errno = ENOSYS;
+  return NULL;
+}
+
+ExecutiveShared* executiveSharedOpen( const char* name ) {
+  (void)name;
+  errno = ENOSYS;
+  return NULL;
+}
+
+void executiveSharedClose( ExecutiveShared* s ) {
+  (void)s;
+}
+
+int executiveSharedUnlink( const char* name ) {
+  (void)name;
+  errno = ENOSYS;
+  return -1;
+}
+
+ExecutiveSharedId executiveSharedAdd( ExecutiveShared* s,
+									  struct timeval* scheduledTime,
+									  unsigned kind,
+									  const void* env, size_t envSize ) {
+  (void)s;
+  (void)scheduledTime;
+  (void)kind;
+  (void)env;
+  (void)envSize;
+  return 0;
+}
+
+int executiveSharedCancel( ExecutiveShared* s, ExecutiveSharedId id ) {
+  (void)s;
+  (void)id;
+  return -1;
+}
+
+size_t executiveSharedLength( ExecutiveShared* s ) {
+  (void)s;
+  return 0;
+}
+
+int executiveSharedSetAction( ExecutiveShared* s, unsigned kind,
+							  Action action ) {
+  (void)s;
+  (void)kind;
+  (void)action;
+  return -1;
+}
+
+int executiveSharedRunOnce( ExecutiveShared* s, struct timeval* timeout ) {
+  (void)s;
+  (void)timeout;
+  errno = ENOSYS;
+  return -1;
+}
+
+#endif
+
+// eof
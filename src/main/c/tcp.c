@@ -0,0 +1,408 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "executive/tcp.h"
+#include "executive/loop.h"
+#include "executive-private.h"
+
+struct ExecutiveListener {
+  Executive* executive;
+  int fd;
+  unsigned short port;
+  size_t accepted;
+
+  // shared by all accepted connections' idle timeouts, NULL for none
+  ExecutiveTimeoutQueue* idle;
+
+  AcceptAction accept;
+  void* env;
+
+  // executiveListenerFree called from within the accept action
+  bool accepting;
+  bool freed;
+};
+
+struct ExecutiveConnection {
+  Executive* executive;
+  int fd;
+  ExecutiveOutput* output;
+
+  // the pending idle timeout, NULL for none
+  Event* idle;
+
+  ConnectionReadAction read;
+  ConnectionWriteAction write;
+  ConnectionCloseAction close;
+  void* env;
+
+  // executiveConnectionClose called from within one of the actions
+  bool delivering;
+  bool freed;
+};
+
+// One read per wakeup, of at most this, onto the stack
+#define CONNECTION_READ 16384
+
+static void listenerReadable( Event* e, struct timeval* actualTime );
+static int listenerAccept( int fd );
+static void listenerRelease( ExecutiveListener* thiz );
+static ExecutiveConnection* connectionNew( Executive* e, int fd,
+										   ExecutiveTimeoutQueue* idle,
+										   struct timeval* now );
+static void connectionReadable( Event* e, struct timeval* actualTime );
+static void connectionIdle( Event* e, struct timeval* actualTime );
+static void connectionDrained( ExecutiveOutput* out, void* arg );
+static void connectionEnd( ExecutiveConnection* thiz, int error );
+static bool connectionEnter( ExecutiveConnection* thiz );
+static void connectionLeave( ExecutiveConnection* thiz, bool delivering );
+static void connectionRelease( ExecutiveConnection* thiz );
+static int setNonBlocking( int fd );
+
+ExecutiveListener* executiveListenerNew( Executive* e, const char* host,
+										 unsigned short port, int flags,
+										 AcceptAction accept, void* env ) {
+  char service[8];
+  snprintf( service, sizeof( service ), "%u", port );
+  struct addrinfo hints = { .ai_family = AF_UNSPEC,
+							.ai_socktype = SOCK_STREAM,
+							.ai_flags = AI_PASSIVE | AI_NUMERICSERV };
+  struct addrinfo* ai;
+  int sc = getaddrinfo( host, service, &hints, &ai );
+  if( sc ) {
+	if( sc != EAI_SYSTEM )
+	  errno = sc == EAI_MEMORY ? ENOMEM : EINVAL;
+	return NULL;
+  }
+
+  int fd = socket( ai->ai_family, ai->ai_socktype, ai->ai_protocol );
+  if( fd < 0 ) {
+	freeaddrinfo( ai );
+	return NULL;
+  }
+  int one = 1;
+  sc = setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof( one ) );
+  if( !sc && (flags & EXECUTIVE_LISTEN_REUSEPORT) ) {
+#ifdef SO_REUSEPORT
+	sc = setsockopt( fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof( one ) );
+#else
+	errno = ENOSYS;
+	sc = -1;
+#endif
+  }
+  if( !sc )
+	sc = bind( fd, ai->ai_addr, ai->ai_addrlen );
+  freeaddrinfo( ai );
+  if( !sc )
+	sc = listen( fd, SOMAXCONN );
+  if( !sc )
+	sc = setNonBlocking( fd );
+
+  struct sockaddr_storage bound;
+  socklen_t boundLength = sizeof( bound );
+  if( !sc )
+	sc = getsockname( fd, (struct sockaddr*)&bound, &boundLength );
+
+  ExecutiveListener* result = NULL;
+  if( !sc )
+	result = (ExecutiveListener*)calloc( 1, sizeof( ExecutiveListener ) );
+  if( !result ) {
+	close( fd );
+	return NULL;
+  }
+  result->executive = e;
+  result->fd = fd;
+  result->port = ntohs( bound.ss_family == AF_INET6 ?
+						((struct sockaddr_in6*)&bound)->sin6_port :
+						((struct sockaddr_in*)&bound)->sin_port );
+  result->accept = accept;
+  result->env = env;
+  if( executiveWatchFd( e, fd, listenerReadable, result ) ) {
+	close( fd );
+	free( result );
+	return NULL;
+  }
+  return result;
+}
+
+int executiveListenerSetIdle( ExecutiveListener* thiz, struct timeval* idle ) {
+  if( !idle ) {
+	thiz->idle = NULL;
+	return 0;
+  }
+  thiz->idle = executiveTimeoutQueue( thiz->executive, idle );
+  return thiz->idle ? 0 : -1;
+}
+
+unsigned short executiveListenerPort( ExecutiveListener* thiz ) {
+  return thiz->port;
+}
+
+size_t executiveListenerAccepted( ExecutiveListener* thiz ) {
+  return thiz->accepted;
+}
+
+int executiveListenerFd( ExecutiveListener* thiz ) {
+  return thiz->fd;
+}
+
+void executiveListenerFree( ExecutiveListener* thiz ) {
+  if( thiz->accepting ) {
+	thiz->freed = true;
+	return;
+  }
+  listenerRelease( thiz );
+}
+
+ExecutiveConnection* executiveConnectionNew( Executive* e, int fd,
+											 struct timeval* idle,
+											 struct timeval* now ) {
+  ExecutiveTimeoutQueue* q = NULL;
+  if( idle && !(q = executiveTimeoutQueue( e, idle )) )
+	return NULL;
+  if( setNonBlocking( fd ) )
+	return NULL;
+  return connectionNew( e, fd, q, now );
+}
+
+void executiveConnectionSetActions( ExecutiveConnection* thiz,
+									ConnectionReadAction read,
+									ConnectionWriteAction write,
+									ConnectionCloseAction close,
+									void* env ) {
+  thiz->read = read;
+  thiz->write = write;
+  thiz->close = close;
+  thiz->env = env;
+}
+
+int executiveConnectionWrite( ExecutiveConnection* thiz,
+							  const void* data, size_t length ) {
+  return executiveOutputWrite( thiz->output, data, length );
+}
+
+ExecutiveOutput* executiveConnectionOutput( ExecutiveConnection* thiz ) {
+  return thiz->output;
+}
+
+void executiveConnectionClose( ExecutiveConnection* thiz ) {
+  if( thiz->delivering ) {
+	thiz->freed = true;
+	return;
+  }
+  connectionRelease( thiz );
+}
+
+int executiveConnectionFd( ExecutiveConnection* thiz ) {
+  return thiz->fd;
+}
+
+/******************************* STATICS **********************************/
+
+/*
+  Accept until none are pending, or the batch is done, any remainder
+  then waiting for the next wakeup.  An error such as EMFILE likewise
+  ends the batch.
+*/
+static void listenerReadable( Event* e, struct timeval* actualTime ) {
+  ExecutiveListener* thiz = (ExecutiveListener*)executiveEventEnv( e );
+  thiz->accepting = true;
+  for( int i = 0; i < EXECUTIVE_ACCEPT_BATCH && !thiz->freed; i++ ) {
+	int fd = listenerAccept( thiz->fd );
+	if( fd < 0 )
+	  break;
+	// requests and replies are small, and output is coalesced anyway
+	int one = 1;
+	setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+	ExecutiveConnection* c = connectionNew( thiz->executive, fd,
+											thiz->idle, actualTime );
+	if( !c ) {
+	  close( fd );
+	  continue;
+	}
+	thiz->accepted++;
+	if( thiz->accept )
+	  thiz->accept( thiz, c, actualTime, thiz->env );
+  }
+  thiz->accepting = false;
+  if( thiz->freed )
+	listenerRelease( thiz );
+}
+
+// The new fd non-blocking and close-on-exec, in one call where we can
+static int listenerAccept( int fd ) {
+#ifdef __linux__
+  return accept4( fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC );
+#else
+  int result = accept( fd, NULL, NULL );
+  if( result >= 0 &&
+	  (setNonBlocking( result ) || fcntl( result, F_SETFD, FD_CLOEXEC )) ) {
+	close( result );
+	return -1;
+  }
+  return result;
+#endif
+}
+
+static void listenerRelease( ExecutiveListener* thiz ) {
+  executiveUnwatchFd( thiz->executive, thiz->fd );
+  close( thiz->fd );
+  free( thiz );
+}
+
+static ExecutiveConnection* connectionNew( Executive* e, int fd,
+										   ExecutiveTimeoutQueue* idle,
+										   struct timeval* now ) {
+  ExecutiveConnection* result = (ExecutiveConnection*)calloc
+	( 1, sizeof( ExecutiveConnection ) );
+  if( !result )
+	return NULL;
+  result->executive = e;
+  result->fd = fd;
+  result->output = executiveOutputNew( e, fd );
+  if( result->output &&
+	  !executiveWatchFd( e, fd, connectionReadable, result ) ) {
+	if( !idle ||
+		(result->idle = executiveTimeoutAdd( idle, now, connectionIdle,
+											 result )) ) {
+	  executiveOutputSetDrained( result->output, connectionDrained, result );
+	  return result;
+	}
+	executiveUnwatchFd( e, fd );
+  }
+  if( result->output )
+	executiveOutputFree( result->output );
+  free( result );
+  return NULL;
+}
+
+static void connectionReadable( Event* e, struct timeval* actualTime ) {
+  ExecutiveConnection* thiz = (ExecutiveConnection*)executiveEventEnv( e );
+  char buffer[CONNECTION_READ];
+  ssize_t nin = read( thiz->fd, buffer, sizeof( buffer ) );
+  if( nin < 0 ) {
+	if( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+	  connectionEnd( thiz, errno );
+	return;
+  }
+  if( nin == 0 ) {
+	connectionEnd( thiz, 0 );
+	return;
+  }
+  if( thiz->idle )
+	executiveTimeoutTouch( thiz->idle, actualTime );
+  if( !thiz->read )
+	return;
+  bool delivering = connectionEnter( thiz );
+  thiz->read( thiz, buffer, (size_t)nin, thiz->env );
+  connectionLeave( thiz, delivering );
+}
+
+static void connectionIdle( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  ExecutiveConnection* thiz = (ExecutiveConnection*)executiveEventEnv( e );
+  // the Event is free'd as we return
+  thiz->idle = NULL;
+  connectionEnd( thiz, ETIMEDOUT );
+}
+
+static void connectionDrained( ExecutiveOutput* out, void* arg ) {
+  (void)out;
+  ExecutiveConnection* thiz = (ExecutiveConnection*)arg;
+  if( !thiz->write )
+	return;
+  bool delivering = connectionEnter( thiz );
+  thiz->write( thiz, thiz->env );
+  connectionLeave( thiz, delivering );
+}
+
+// The connection goes, whether or not the close action closes it too
+static void connectionEnd( ExecutiveConnection* thiz, int error ) {
+  bool delivering = connectionEnter( thiz );
+  if( thiz->close )
+	thiz->close( thiz, error, thiz->env );
+  thiz->freed = true;
+  connectionLeave( thiz, delivering );
+}
+
+/*
+  Around each action call, so that an executiveConnectionClose within
+  it is deferred until it returns. Calls may nest, e.g. a drained
+  callback from an executiveOutputFlush within a read action.
+*/
+static bool connectionEnter( ExecutiveConnection* thiz ) {
+  bool result = thiz->delivering;
+  thiz->delivering = true;
+  return result;
+}
+
+static void connectionLeave( ExecutiveConnection* thiz, bool delivering ) {
+  thiz->delivering = delivering;
+  if( !delivering && thiz->freed )
+	connectionRelease( thiz );
+}
+
+static void connectionRelease( ExecutiveConnection* thiz ) {
+  if( thiz->idle )
+	executiveTimeoutCancel( thiz->idle );
+  executiveUnwatchFd( thiz->executive, thiz->fd );
+  executiveOutputSetDrained( thiz->output, NULL, NULL );
+  executiveOutputFlush( thiz->output );
+  executiveOutputFree( thiz->output );
+  close( thiz->fd );
+  free( thiz );
+}
+
+static int setNonBlocking( int fd ) {
+  int flags = fcntl( fd, F_GETFL );
+  if( flags < 0 )
+	return -1;
+  return fcntl( fd, F_SETFL, flags | O_NONBLOCK );
+}
+
+// eof
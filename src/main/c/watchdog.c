@@ -0,0 +1,269 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "executive/watchdog.h"
+#include "executive-private.h"
+
+struct ExecutiveWatchdog {
+  Executive* executive;
+  struct timeval budget;
+  OverrunAction report;
+  void* arg;
+
+  // the firing thread, to be signalled for stack samples
+  pthread_t target;
+
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  bool stopping;
+};
+
+/*
+  A stack sample, taken by the signal handler, on the sampled thread.
+  Process-wide, so watchdogs take turns, via 'lock'.  The signal is
+  ours if a sample is 'wanted', else goes to the 'previous' handler.
+*/
+static struct {
+  pthread_mutex_t lock;
+  void* stack[EXECUTIVE_WATCHDOG_STACK];
+  int depth;
+  int wanted;
+  int done;
+  struct sigaction previous;
+} sample = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static pthread_once_t sampleOnce = PTHREAD_ONCE_INIT;
+
+static void* watchdogRun( void* arg );
+static void watchdogCheck( ExecutiveWatchdog* thiz, uint64_t* seen,
+						   struct timespec* seenAt, uint64_t* reported );
+static int watchdogSample( ExecutiveWatchdog* thiz, void** stack );
+static void sampleInit( void );
+static void sampleHandler( int signo, siginfo_t* info, void* context );
+static void overrunPrint( ExecutiveOverrun* o, void* arg );
+static int64_t nanosSince( struct timespec* then );
+
+ExecutiveWatchdog* executiveWatchdogNew( Executive* e,
+										 struct timeval* budget,
+										 OverrunAction report,
+										 void* arg ) {
+  if( e->watchdog ) {
+	errno = EBUSY;
+	return NULL;
+  }
+  pthread_once( &sampleOnce, sampleInit );
+  ExecutiveWatchdog* result = malloc( sizeof( ExecutiveWatchdog ) );
+  if( !result )
+	return NULL;
+  result->executive = e;
+  result->budget = *budget;
+  result->report = report ? report : overrunPrint;
+  result->arg = arg;
+  result->target = pthread_self();
+  result->stopping = false;
+  pthread_mutex_init( &result->mutex, NULL );
+  pthread_cond_init( &result->cond, NULL );
+  int sc = executiveThreadCreate( &result->thread, watchdogRun, result );
+  if( sc ) {
+	pthread_cond_destroy( &result->cond );
+	pthread_mutex_destroy( &result->mutex );
+	free( result );
+	errno = sc;
+	return NULL;
+  }
+  e->watchdog = result;
+  return result;
+}
+
+void executiveWatchdogFree( ExecutiveWatchdog* thiz ) {
+  pthread_mutex_lock( &thiz->mutex );
+  thiz->stopping = true;
+  pthread_cond_signal( &thiz->cond );
+  pthread_mutex_unlock( &thiz->mutex );
+  pthread_join( thiz->thread, NULL );
+  thiz->executive->watchdog = NULL;
+  pthread_cond_destroy( &thiz->cond );
+  pthread_mutex_destroy( &thiz->mutex );
+  free( thiz );
+}
+
+/******************************* STATICS **********************************/
+
+static void* watchdogRun( void* arg ) {
+  ExecutiveWatchdog* thiz = (ExecutiveWatchdog*)arg;
+  int64_t budget = (int64_t)thiz->budget.tv_sec * 1000000000 +
+	thiz->budget.tv_usec * 1000;
+  int64_t tick = budget / 8 > 1000000 ? budget / 8 : 1000000;
+
+  uint64_t seen = 0, reported = 0;
+  struct timespec seenAt = { 0, 0 };
+  pthread_mutex_lock( &thiz->mutex );
+  while( !thiz->stopping ) {
+	struct timespec until;
+	clock_gettime( CLOCK_REALTIME, &until );
+	until.tv_sec += tick / 1000000000;
+	until.tv_nsec += tick % 1000000000;
+	if( until.tv_nsec >= 1000000000 ) {
+	  until.tv_sec++;
+	  until.tv_nsec -= 1000000000;
+	}
+	pthread_cond_timedwait( &thiz->cond, &thiz->mutex, &until );
+	if( thiz->stopping )
+	  break;
+	pthread_mutex_unlock( &thiz->mutex );
+	watchdogCheck( thiz, &seen, &seenAt, &reported );
+	pthread_mutex_lock( &thiz->mutex );
+  }
+  pthread_mutex_unlock( &thiz->mutex );
+  return NULL;
+}
+
+/*
+  The same firing serial seen for at least budget is an overrun.  The
+  Action and time are read between two loads of the serial, as a
+  seqlock, and are only believed if it is unchanged, so still that
+  Event's.
+*/
+static void watchdogCheck( ExecutiveWatchdog* thiz, uint64_t* seen,
+						   struct timespec* seenAt, uint64_t* reported ) {
+  Executive* e = thiz->executive;
+  uint64_t firing = __atomic_load_n( &e->firing, __ATOMIC_ACQUIRE );
+  if( firing != *seen ) {
+	*seen = firing;
+	clock_gettime( CLOCK_MONOTONIC, seenAt );
+	return;
+  }
+  if( !firing || firing == *reported )
+	return;
+  int64_t elapsed = nanosSince( seenAt );
+  if( elapsed < (int64_t)thiz->budget.tv_sec * 1000000000 +
+	  thiz->budget.tv_usec * 1000 )
+	return;
+
+  ExecutiveOverrun o;
+  o.executive = e;
+  o.action = __atomic_load_n( &e->firingAction, __ATOMIC_RELAXED );
+  o.scheduledTime.tv_sec = __atomic_load_n( &e->firingScheduled.tv_sec,
+											__ATOMIC_RELAXED );
+  o.scheduledTime.tv_usec = __atomic_load_n( &e->firingScheduled.tv_usec,
+											 __ATOMIC_RELAXED );
+  __atomic_thread_fence( __ATOMIC_ACQUIRE );
+  if( __atomic_load_n( &e->firing, __ATOMIC_RELAXED ) != firing )
+	return;
+  o.elapsed.tv_sec = elapsed / 1000000000;
+  o.elapsed.tv_usec = (elapsed % 1000000000) / 1000;
+  o.stackDepth = watchdogSample( thiz, o.stack );
+  *reported = firing;
+  thiz->report( &o, thiz->arg );
+}
+
+// 0 frames if the target does not answer in time
+static int watchdogSample( ExecutiveWatchdog* thiz, void** stack ) {
+  int result = 0;
+  pthread_mutex_lock( &sample.lock );
+  __atomic_store_n( &sample.done, 0, __ATOMIC_RELEASE );
+  __atomic_store_n( &sample.wanted, 1, __ATOMIC_RELEASE );
+  if( pthread_kill( thiz->target, EXECUTIVE_WATCHDOG_SIGNAL ) == 0 ) {
+	struct timespec pause = { 0, 1000000 };
+	for( int i = 0; i < 100; i++ ) {
+	  if( __atomic_load_n( &sample.done, __ATOMIC_ACQUIRE ) ) {
+		result = sample.depth;
+		for( int j = 0; j < result; j++ )
+		  stack[j] = sample.stack[j];
+		break;
+	  }
+	  nanosleep( &pause, NULL );
+	}
+  }
+  __atomic_store_n( &sample.wanted, 0, __ATOMIC_RELEASE );
+  pthread_mutex_unlock( &sample.lock );
+  return result;
+}
+
+/*
+  backtrace is not async-signal-safe on first use, when it may load
+  the unwinder, so is called once here, beforehand.  Any handler
+  already installed is kept, for signals not ours.
+*/
+static void sampleInit( void ) {
+  void* frames[1];
+  backtrace( frames, 1 );
+  struct sigaction sa;
+  sa.sa_sigaction = sampleHandler;
+  sigemptyset( &sa.sa_mask );
+  sa.sa_flags = SA_RESTART | SA_SIGINFO;
+  sigaction( EXECUTIVE_WATCHDOG_SIGNAL, &sa, &sample.previous );
+}
+
+static void sampleHandler( int signo, siginfo_t* info, void* context ) {
+  if( !__atomic_exchange_n( &sample.wanted, 0, __ATOMIC_ACQ_REL ) ) {
+	struct sigaction* p = &sample.previous;
+	if( p->sa_flags & SA_SIGINFO )
+	  p->sa_sigaction( signo, info, context );
+	else if( p->sa_handler != SIG_DFL && p->sa_handler != SIG_IGN )
+	  p->sa_handler( signo );
+	return;
+  }
+  int saved = errno;
+  sample.depth = backtrace( sample.stack, EXECUTIVE_WATCHDOG_STACK );
+  __atomic_store_n( &sample.done, 1, __ATOMIC_RELEASE );
+  errno = saved;
+}
+
+static void overrunPrint( ExecutiveOverrun* o, void* arg ) {
+  (void)arg;
+  fprintf( stderr, "executive: Action %p, scheduled %ld.%06ld, "
+		   "overran: %ld.%06lds so far\n", (void*)o->action,
+		   (long)o->scheduledTime.tv_sec, (long)o->scheduledTime.tv_usec,
+		   (long)o->elapsed.tv_sec, (long)o->elapsed.tv_usec );
+  backtrace_symbols_fd( o->stack, o->stackDepth, STDERR_FILENO );
+}
+
+static int64_t nanosSince( struct timespec* then ) {
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return (int64_t)(now.tv_sec - then->tv_sec) * 1000000000 +
+	(now.tv_nsec - then->tv_nsec);
+}
+
+// eof
@@ -0,0 +1,125 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_CONCURRENT_H
+#define _EXECUTIVE_CONCURRENT_H
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	A concurrent Executive, for a pure timer service where many
+	threads add Events to, and fire Events from, one shared Executive,
+	rather than each owning a shard.
+
+	It is a 'MultiQueue': several time-ordered heaps, each with its
+	own lock.  Adds go to a randomly chosen heap.  Fires look at the
+	heads of two randomly chosen heaps and take the earlier, so
+	threads rarely contend for one lock, and the structure scales with
+	the number of threads.  The price is relaxed ordering.  Compared
+	with the single-threaded Executive:
+
+	+ add, peek, fire and length are all thread-safe, and may be
+	  called from within Actions.
+
+	+ fire only ever fires an Event due by 'now', and fires one if
+	  any was due throughout the call.  It is not necessarily the
+	  earliest due one, but is typically among the earliest few (of
+	  the order of the number of heaps), even with just one thread
+	  firing.  Equal times are not FIFO.  Where Events must fire in
+	  strict order, use the ordinary Executive.
+
+	+ peek is a snapshot, stale as soon as returned, so copies the
+	  time out rather than returning a pointer.
+
+	+ Actions get the usual Event, bar executiveEventExecutive, which
+	  returns NULL.  Any re-add is via the ConcurrentExecutive, e.g. as
+	  (part of) the env.
+
+	+ there is no clearing, nor env freeing, nor timeout queues.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct ConcurrentExecutive;
+  typedef struct ConcurrentExecutive ConcurrentExecutive;
+
+  /**
+   * @param threads - expected number of threads using it. Sizes the
+   * number of heaps, a few per thread.
+   */
+  ConcurrentExecutive* executiveConcurrentNew( size_t threads );
+
+  /**
+   * Not while any thread is still using it. Pending Events are
+   * discarded, not fired.
+   */
+  void executiveConcurrentFree( ConcurrentExecutive* ce );
+
+  /**
+   * @return 0, or -1 if no memory
+   */
+  int executiveConcurrentAdd( ConcurrentExecutive* ce,
+							  struct timeval* scheduledTime,
+							  Action action, void* env );
+
+  /**
+   * @param result - set to the earliest scheduled time pending
+   *
+   * @return false if nothing pending (result untouched)
+   */
+  bool executiveConcurrentPeek( ConcurrentExecutive* ce,
+								struct timeval* result );
+
+  /**
+   * Remove one Event due by 'now' and call its Action, with 'now' as
+   * its actualTime, on the calling thread.
+   *
+   * @return true if an Event was fired, false if none was due
+   */
+  bool executiveConcurrentFire( ConcurrentExecutive* ce,
+								struct timeval* now );
+
+  size_t executiveConcurrentLength( ConcurrentExecutive* ce );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
@@ -0,0 +1,99 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_DEBOUNCE_H
+#define _EXECUTIVE_DEBOUNCE_H
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	Debounce and throttle: coalescing many triggers, for some key,
+	into few Action calls.  Each key has at most one Event pending,
+	found via a hash table, and a trigger merely notes its time in the
+	key's entry, the Event catching up lazily when it fires.  So each
+	trigger is O(1), however long the burst.
+
+	+ debounce: call the Action 'delay' after the last of a burst of
+	  triggers, e.g. to save a file once edits pause.
+
+	+ throttle: call the Action at most once per 'interval'.  A first
+	  trigger calls it at once (as soon as the loop next fires Events),
+	  and any further triggers within the interval result in just one
+	  more call, at the interval's end.
+
+	A trigger replaces the key's Action and env, so the call made is
+	that of the latest trigger.  The Event passed has that env.  Keys
+	are per Executive, and are compared as pointers.
+
+	Times given are 'now', as per executiveTimeoutAdd.
+
+	A key waiting on, after its Event fires early or after a throttled
+	call, needs its Event re-added.  Should that fail, the Executive
+	being full (EXECUTIVE_FULL, see executiveSetLimits), no call is
+	dropped: a debounced key's call is made at once, early, and a
+	throttled key is forgotten, so its next trigger calls at once.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * @return 0, or -1 if out of memory, or the Executive is full
+   */
+  int executiveDebounce( Executive* e, void* key, struct timeval* now,
+						 struct timeval* delay, Action action, void* env );
+
+  /**
+   * @return 0, or -1 if out of memory, or the Executive is full
+   */
+  int executiveThrottle( Executive* e, void* key, struct timeval* now,
+						 struct timeval* interval, Action action, void* env );
+
+  /**
+   * Forget key, so that any call pending for it is NOT made.
+   *
+   * @return 0, or -1 if key is unknown
+   */
+  int executiveDebounceCancel( Executive* e, void* key );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
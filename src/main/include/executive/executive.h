@@ -35,9 +35,25 @@
 #ifndef _EXECUTIVE_TIME_ORDERED_QUEUE_H
 #define _EXECUTIVE_TIME_ORDERED_QUEUE_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <sys/time.h>
 
+/*
+  Bytes of env storage held inline in every Event, see
+  executiveAddInline.  Must be the same value for the library and its
+  callers.
+*/
+#ifndef EXECUTIVE_INLINE_ENV_SIZE
+#define EXECUTIVE_INLINE_ENV_SIZE 32
+#endif
+
+/*
+  An upper bound on the size of an Event, see executiveAddWithStorage.
+  The library checks this at build time.
+*/
+#define EXECUTIVE_EVENT_SIZE (16 * sizeof(void*) + EXECUTIVE_INLINE_ENV_SIZE)
+
 /** 
     @author Stuart Maclean
 
@@ -113,7 +129,9 @@
     of 'schedule' and 'fire', we will always get a defined
     response/action.
 
-	For the data structures needed for our Executive, we use GLib.
+	For the data structures needed for our Executive, we use GLib
+	(libexecutive-glib.a) or, built without EXECUTIVE_GLIB, intrusive
+	lists linked through the Events themselves (libexecutive.a).
 */
 
 #ifdef __cplusplus
@@ -122,6 +140,15 @@ extern "C" {
   
   struct Event;
   typedef struct Event Event;
+
+  /**
+	 Caller-owned memory for one Event, for executiveAddWithStorage.
+	 Opaque, only its size and alignment are of interest.
+  */
+  typedef union ExecutiveEventStorage {
+	max_align_t align;
+	unsigned char bytes[EXECUTIVE_EVENT_SIZE];
+  } ExecutiveEventStorage;
   
   typedef void (*Action)( Event* e, struct timeval* actualTime );
 
@@ -130,11 +157,43 @@ extern "C" {
   
   Executive* executiveNew(void);
 
+  /**
+   * Bytes of storage needed by executiveInitStatic for an Executive
+   * holding up to 'capacity' Events.
+   */
+  size_t executiveStaticSize( size_t capacity );
+
+  /**
+   * Create an Executive entirely within caller-supplied storage, for
+   * use where malloc is unwelcome (embedded, real-time). Events are
+   * taken from, and returned to, a free list of 'capacity' slots in
+   * that storage, both in O(1).  Each timeout queue also occupies one
+   * slot, for the Executive's lifetime.  The storage is never free'd
+   * by us, executiveFree just discards any pending Events.  Note that
+   * only libexecutive.a is then malloc-free, the GLib build still
+   * allocates a list node per Event.
+   *
+   * @param storage - at least executiveStaticSize(capacity) bytes,
+   * aligned for any type (as malloc's result would be)
+   *
+   * @return the Executive, which lives at the start of storage
+   */
+  Executive* executiveInitStatic( void* storage, size_t capacity );
+
   void executiveFree( Executive* );
 
+  /**
+	 Returned by the add routines when no Event could be had: a static
+	 Executive is at capacity, malloc failed, or the Event would exceed
+	 a limit set by executiveSetLimits.  Nothing was added.
+  */
+#define EXECUTIVE_FULL ((size_t)-1)
+
   /**
    * @param scheduledTime - absolute time at which event should fire
    * @param action - what action to perform at event time
+   *
+   * @return number of Events now pending, or EXECUTIVE_FULL
    */
   size_t executiveAdd( Executive* e, 
 					   struct timeval* scheduledTime, Action action );
@@ -158,7 +217,71 @@ extern "C" {
   size_t executiveAddWithFreeFunc( Executive* e, 
 								 struct timeval* scheduledTime, Action action,
 								 void* env, void (*envFree)( void* ) );
+
+  /**
+	 One Event to add, for executiveAddBatch.
+  */
+  typedef struct EventSpec {
+	struct timeval scheduledTime;
+	Action action;
+	void* env;
+  } EventSpec;
+
+  /**
+   * Add n Events at once, e.g. at startup or on a config reload. The
+   * batch is sorted (specs need not be, though already sorted is
+   * cheapest), then merged into the pending Events in a single pass,
+   * so O(n log n + m) for m pending, rather than n separate adds.  The
+   * n Events share one allocation.  Equal times keep their order
+   * within the batch.
+   *
+   * @return number of Events now pending, or EXECUTIVE_FULL if the
+   * whole batch could not be had (or would exceed limits), in which
+   * case none were added.
+   */
+  size_t executiveAddBatch( Executive* e, const EventSpec* specs, size_t n );
+
+  /**
+   * As above, but where env's size is known, and counted, along with
+   * the Event itself, against any maxBytes limit (executiveSetLimits).
+   * Other add routines count only the Event.
+   */
+  size_t executiveAddWithEnvSize( Executive* e,
+								  struct timeval* scheduledTime,
+								  Action action, void* env, size_t envSize,
+								  void (*envFree)( void* ) );
+
+  /**
+   * As above, but where the env is small enough to live inside the
+   * Event itself, saving a separate allocation.  The caller
+   * places/constructs the env in the returned storage, which is
+   * aligned for any type and is what executiveEventEnv then returns.
+   * The storage is NOT free'd separately, so envDestroy (may be NULL)
+   * should only destroy, never free, the env.
+   *
+   * @param envSize - must be at most EXECUTIVE_INLINE_ENV_SIZE
+   *
+   * @return the env storage, or NULL if envSize is too big or the
+   * Event could not be allocated.
+   */
+  void* executiveAddInline( Executive* e,
+							struct timeval* scheduledTime, Action action,
+							size_t envSize, void (*envDestroy)( void* ) );
   
+  /**
+   * As executiveAddWithEnv, but where the Event itself lives in memory
+   * supplied by the caller, typically a member of some longer-lived
+   * object, so there is no allocation at all (bar a GList node in the
+   * GLib build).  The storage must stay put, and not be reused, until
+   * the Event fires or is discarded. It is never free'd by us, nor
+   * touched once its Action is called, so that Action may re-add the
+   * same storage.
+   */
+  size_t executiveAddWithStorage( Executive* e,
+								  ExecutiveEventStorage* storage,
+								  struct timeval* scheduledTime,
+								  Action action, void* env );
+
   /**
    * Peek at the time of earliest event on the supplied executive.
    * 
@@ -213,13 +336,179 @@ extern "C" {
   */
   size_t executiveClearMatchingEnv( Executive*, void* env );
 
+  /**
+	 Cancel (clear) all events with both Action and env matching those
+	 supplied.  Discarded events are NOT fired.  Like all the clears,
+	 a scan of the whole Executive, so for one Event cancelled often,
+	 see debounce.h.
+
+	 @result number of user Events discarded
+  */
+  size_t executiveClearMatchingActionAndEnv( Executive*, Action a, void* env );
+
+  /**
+	 Move all events of 'src' satisfying 'pred' (all of them, if pred
+	 is NULL) to 'dst', e.g. to rebalance work between loop threads.
+	 The Events themselves are relinked, not copied, so no envFree is
+	 called, and executiveEventExecutive then gives 'dst'.  Events on a
+	 timeout queue go to dst's queue of the same duration.  A debounce
+	 or throttle key (debounce.h) moves with its Event, unless dst has
+	 that key too, when the moved one's pending call is made but it
+	 takes no more triggers.
+
+	 Only src's own Events move, not those of any children.  dst's
+	 limits (see executiveSetLimits) are not applied, the Events being
+	 already admitted, but its watermarks are.  Events from a static
+	 Executive still occupy its storage, so it must outlive them.
+
+	 O(n + m), n and m the lengths of src and dst.
+
+	 @result number of Events moved
+  */
+  size_t executiveMigrate( Executive* src, Executive* dst,
+						   bool (*pred)( Event*, void* ctx ), void* ctx );
+
+  /**
+	 Move every Event of 'src' to 'dst', as per executiveMigrate.
+
+	 @result number of Events moved
+  */
+  size_t executiveMerge( Executive* dst, Executive* src );
+
   Executive* executiveEventExecutive( Event* );
 
   struct timeval* executiveEventScheduledTime( Event* );
 
   void* executiveEventEnv( Event* );
 
-  
+  /**
+	 Timeout queues.  Many timeouts share one of a small set of
+	 durations (idle connections, request deadlines).  When every
+	 Event on a queue has the same duration D, and each is scheduled at
+	 'now + D', deadlines arrive in order, so a plain FIFO is already
+	 time-sorted.  Add, touch (re-arm) and cancel are then O(1), and
+	 the Executive need only consult the head of each queue when
+	 peeking/firing.
+
+	 Timeout queues are owned by their Executive, and freed by
+	 executiveFree.  Events on them are peeked, fired, counted and
+	 cleared just like any other Event on the Executive.
+  */
+  struct ExecutiveTimeoutQueue;
+  typedef struct ExecutiveTimeoutQueue ExecutiveTimeoutQueue;
+
+  /**
+   * Locate the timeout queue for the supplied duration, creating it
+   * on first use.
+   *
+   * @param duration - the (relative) timeout shared by all Events on
+   * the queue
+   */
+  ExecutiveTimeoutQueue* executiveTimeoutQueue( Executive* e,
+												struct timeval* duration );
+
+  /**
+   * Schedule an Event for time 'now + duration' at the tail of the
+   * queue.  Should 'now' precede the time used for the current tail
+   * (a clock step backwards), the new Event takes the tail's time, so
+   * the queue stays sorted.
+   *
+   * @return the new Event, a handle for touch/cancel. It remains
+   * valid until the Event fires or is cancelled/cleared.
+   */
+  Event* executiveTimeoutAdd( ExecutiveTimeoutQueue* q, struct timeval* now,
+							  Action action, void* env );
+
+  /**
+   * Re-arm a pending timeout Event, moving it to time 'now + duration'
+   * at the tail of its queue. O(1).
+   */
+  void executiveTimeoutTouch( Event* e, struct timeval* now );
+
+  /**
+   * Cancel a pending timeout Event.  It is NOT fired, but its env is
+   * freed as per executiveClear. O(1).
+   */
+  void executiveTimeoutCancel( Event* e );
+
+  size_t executiveTimeoutQueueLength( ExecutiveTimeoutQueue* q );
+
+  /**
+   * @return the timeout queue on which an Event was placed, or NULL
+   * for Events added via executiveAdd and friends.
+   */
+  ExecutiveTimeoutQueue* executiveEventTimeoutQueue( Event* );
+
+  /**
+	 Admission control.  A misbehaving producer (e.g. runaway retry
+	 timers) can otherwise add Events until memory runs out.  With
+	 limits set, adds that would exceed either are rejected, returning
+	 EXECUTIVE_FULL (NULL from executiveAddInline/executiveTimeoutAdd),
+	 with no side effects.  Limits apply to an Executive's own Events,
+	 not those of its children.
+
+	 @param maxEvents - most Events pending at once, 0 for no limit
+
+	 @param maxBytes - most bytes held by pending Events, each Event
+	 counting its own size (plus a list node in the GLib build) and
+	 any env size given to executiveAddWithEnvSize. 0 for no limit.
+  */
+  void executiveSetLimits( Executive* e, size_t maxEvents, size_t maxBytes );
+
+  /**
+	 Backpressure. 'callback' is called with above true when more than
+	 'high' Events become pending, then with above false once they
+	 drop back to 'low' or fewer, and so on.  Called from within the
+	 add/fire/clear causing the crossing, so should itself only
+	 (un)throttle producers, not add or clear Events.  NULL callback
+	 for none.
+  */
+  void executiveSetWatermarks( Executive* e, size_t high, size_t low,
+							   void (*callback)( Executive* e, bool above,
+												 void* arg ),
+							   void* arg );
+
+  /**
+   * @return bytes currently counted against maxBytes, whether or not
+   * a limit is set.
+   */
+  size_t executiveBytes( Executive* e );
+
+  /**
+	 Nesting.  A subsystem owning many timers can keep them on an
+	 Executive of its own, attached as a 'child' of the process-wide
+	 one.  The parent tracks each child by just its head time, in a
+	 heap, so a change to that head costs O(log k) for k children, and
+	 executiveClear or executiveFree of a child, however many Events it
+	 holds, is a single such update.
+
+	 Peek, fire and length on a parent then take in the Events of all
+	 its descendants (an Action fired via the parent still sees the
+	 child as its executiveEventExecutive). Clear and friends act only
+	 on an Executive's own Events.  Fd and signal watches are those of
+	 the Executive being run (see loop.h), i.e. the root.
+  */
+
+  /**
+   * Make 'child' a child of 'e'. A static Executive's table of
+   * children is the one thing about it needing malloc.
+   *
+   * @return 0, or -1 if child already has a parent, would form a
+   * cycle, or no memory.
+   */
+  int executiveAttachChild( Executive* e, Executive* child );
+
+  /**
+   * @return 0, or -1 if child is not a child of e.
+   */
+  int executiveDetachChild( Executive* e, Executive* child );
+
+  /**
+   * @return the Executive to which e is attached, or NULL.
+   */
+  Executive* executiveParent( Executive* e );
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,357 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_HPP
+#define _EXECUTIVE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define EXECUTIVE_COROUTINES 1
+#endif
+
+#include "executive/executive.h"
+#include "executive/loop.h"
+
+/**
+	A header-only C++ (17) face on the C Executive.
+
+	Events are scheduled with any callable (typically a lambda with
+	captures) instead of an Action plus a void* env.  Callables small
+	enough (EXECUTIVE_INLINE_ENV_SIZE bytes) are constructed in place
+	inside the Event, so an add costs exactly one allocation, as for
+	the C API.  Larger callables are moved to the heap, and the Event
+	holds just a pointer to them. Either way, the callable's
+	destructor runs after it fires, or when its Event is discarded
+	(clear, cancel, executiveFree).
+
+	A callable may take any of these forms:
+
+	  f()
+	  f( TimePoint actualTime )
+	  f( TimePoint scheduledTime, TimePoint actualTime )
+
+	Callables must not throw, an exception escaping one terminates
+	the program. Recall the C code it would unwind through is not
+	exception-aware.
+
+	Example:
+
+	  executive::Executive E;
+	  auto now = executive::Clock::now();
+	  E.add( now + std::chrono::seconds(5), [&]() { ... } );
+*/
+
+namespace executive {
+
+  using Clock = std::chrono::system_clock;
+  using TimePoint = Clock::time_point;
+
+  inline struct timeval toTimeval( TimePoint t ) {
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>
+	  ( t.time_since_epoch() ).count();
+	struct timeval result;
+	result.tv_sec = us / 1000000;
+	result.tv_usec = us % 1000000;
+	if( result.tv_usec < 0 ) {
+	  result.tv_sec--;
+	  result.tv_usec += 1000000;
+	}
+	return result;
+  }
+
+  inline TimePoint fromTimeval( const struct timeval& tv ) {
+	return TimePoint( std::chrono::duration_cast<Clock::duration>
+					  ( std::chrono::seconds( tv.tv_sec ) +
+						std::chrono::microseconds( tv.tv_usec ) ) );
+  }
+
+#ifdef EXECUTIVE_COROUTINES
+
+  /**
+   * Return type of coroutines run on an Executive. Fire-and-forget: a
+   * coroutine runs at once, up to its first co_await, and its frame is
+   * freed when it completes.
+   */
+  struct Task {
+	struct promise_type {
+	  Task get_return_object() noexcept { return {}; }
+	  std::suspend_never initial_suspend() noexcept { return {}; }
+	  std::suspend_never final_suspend() noexcept { return {}; }
+	  void return_void() noexcept {}
+	  void unhandled_exception() noexcept { std::terminate(); }
+	};
+  };
+
+#endif
+
+  namespace detail {
+
+#ifdef EXECUTIVE_COROUTINES
+
+	// Resume the time-awaiting coroutine whose handle is the env
+	inline void resumeAction( Event* e, struct timeval* actualTime ) {
+	  (void)actualTime;
+	  std::coroutine_handle<>::from_address( executiveEventEnv( e ) ).resume();
+	}
+
+	struct TimeAwaiter {
+	  ::Executive* executive;
+	  struct timeval when;
+	  bool added;
+	  ExecutiveEventStorage storage;
+
+	  bool await_ready() const noexcept { return false; }
+
+	  // not suspended at all if the Executive is full
+	  bool await_suspend( std::coroutine_handle<> h ) noexcept {
+		added = executiveAddWithStorage( executive, &storage, &when,
+										 resumeAction, h.address() )
+		  != EXECUTIVE_FULL;
+		return added;
+	  }
+
+	  // false if the Executive was full, so no time has passed
+	  bool await_resume() const noexcept { return added; }
+	};
+
+	// One-shot: the fd is unwatched before the coroutine resumes
+	struct ReadableAwaiter {
+	  ::Executive* executive;
+	  int fd;
+	  bool watched;
+	  std::coroutine_handle<> handle;
+
+	  static void action( Event* e, struct timeval* actualTime ) {
+		(void)actualTime;
+		auto thiz = static_cast<ReadableAwaiter*>( executiveEventEnv( e ) );
+		executiveUnwatchFd( thiz->executive, thiz->fd );
+		thiz->handle.resume();
+	  }
+
+	  bool await_ready() const noexcept { return false; }
+
+	  bool await_suspend( std::coroutine_handle<> h ) noexcept {
+		handle = h;
+		watched = executiveWatchFd( executive, fd, action, this ) == 0;
+		return watched;
+	  }
+
+	  // false if fd could not be watched, so is not known readable
+	  bool await_resume() const noexcept { return watched; }
+	};
+
+#endif
+
+	template<class F>
+	void invoke( F& f, Event* e, struct timeval* actualTime ) {
+	  if constexpr( std::is_invocable_v<F&> ) {
+		(void)e;
+		(void)actualTime;
+		f();
+	  } else if constexpr( std::is_invocable_v<F&, TimePoint> ) {
+		(void)e;
+		f( fromTimeval( *actualTime ) );
+	  } else {
+		static_assert( std::is_invocable_v<F&, TimePoint, TimePoint>,
+					   "callable must take (), (actual) or "
+					   "(scheduled, actual)" );
+		f( fromTimeval( *executiveEventScheduledTime( e ) ),
+		   fromTimeval( *actualTime ) );
+	  }
+	}
+
+	/*
+	  Inline only if constructing the callable, from Arg, cannot throw,
+	  since its Event is already in the store by then.  Others are
+	  boxed, constructed before their Event is added.
+	*/
+	template<class F, class Arg>
+	constexpr bool fitsInline =
+	  sizeof(F) <= EXECUTIVE_INLINE_ENV_SIZE &&
+	  alignof(F) <= alignof(std::max_align_t) &&
+	  std::is_nothrow_constructible_v<F, Arg>;
+
+	// The callable itself lives in the Event's inline env
+	template<class F>
+	struct Inline {
+	  static void fire( Event* e, struct timeval* actualTime ) noexcept {
+		invoke( *static_cast<F*>( executiveEventEnv( e ) ), e, actualTime );
+	  }
+	  static void destroy( void* env ) noexcept {
+		static_cast<F*>( env )->~F();
+	  }
+	};
+
+	// The Event's inline env holds only a pointer to the callable
+	template<class F>
+	struct Boxed {
+	  static void fire( Event* e, struct timeval* actualTime ) noexcept {
+		invoke( **static_cast<F**>( executiveEventEnv( e ) ), e, actualTime );
+	  }
+	  static void destroy( void* env ) noexcept {
+		delete *static_cast<F**>( env );
+	  }
+	};
+  }
+
+  class Executive {
+  public:
+	Executive() : thiz( executiveNew() ) {
+	  if( !thiz )
+		throw std::bad_alloc();
+	}
+
+	~Executive() {
+	  if( thiz )
+		executiveFree( thiz );
+	}
+
+	/**
+	 * Take ownership of an Executive made via the C API, e.g. by
+	 * executiveInitStatic.
+	 */
+	explicit Executive( ::Executive* e ) noexcept : thiz( e ) {
+	}
+
+	Executive( const Executive& ) = delete;
+	Executive& operator=( const Executive& ) = delete;
+
+	Executive( Executive&& other ) noexcept : thiz( other.thiz ) {
+	  other.thiz = nullptr;
+	}
+
+	Executive& operator=( Executive&& other ) noexcept {
+	  std::swap( thiz, other.thiz );
+	  return *this;
+	}
+
+	/**
+	 * Schedule callable f for time t.
+	 *
+	 * @return the number of Events now pending
+	 */
+	template<class F>
+	size_t add( TimePoint t, F&& f ) {
+	  using Fn = std::decay_t<F>;
+	  struct timeval tv = toTimeval( t );
+	  if constexpr( detail::fitsInline<Fn, F> ) {
+		void* env = executiveAddInline( thiz, &tv, detail::Inline<Fn>::fire,
+										sizeof(Fn),
+										detail::Inline<Fn>::destroy );
+		if( !env )
+		  throw std::bad_alloc();
+		::new( env ) Fn( std::forward<F>( f ) );
+	  } else {
+		Fn* boxed = new Fn( std::forward<F>( f ) );
+		void* env = executiveAddInline( thiz, &tv, detail::Boxed<Fn>::fire,
+										sizeof(Fn*),
+										detail::Boxed<Fn>::destroy );
+		if( !env ) {
+		  delete boxed;
+		  throw std::bad_alloc();
+		}
+		::new( env ) Fn*( boxed );
+	  }
+	  return executiveLength( thiz );
+	}
+
+	TimePoint peek() const {
+	  return fromTimeval( *executivePeek( thiz ) );
+	}
+
+	void fire( TimePoint actualTime ) {
+	  struct timeval tv = toTimeval( actualTime );
+	  executiveFire( thiz, &tv );
+	}
+
+	size_t length() const {
+	  return executiveLength( thiz );
+	}
+
+	size_t clear() {
+	  return executiveClear( thiz );
+	}
+
+	// See loop.h
+	int run() {
+	  return executiveRun( thiz );
+	}
+
+	void stop() {
+	  executiveStop( thiz );
+	}
+
+	size_t runSimulated( TimePoint until ) {
+	  struct timeval tv = toTimeval( until );
+	  return executiveRunSimulated( thiz, &tv );
+	}
+
+#ifdef EXECUTIVE_COROUTINES
+
+	detail::TimeAwaiter until( TimePoint t ) {
+	  return detail::TimeAwaiter{ thiz, toTimeval( t ), false, {} };
+	}
+
+	template<class Rep, class Period>
+	detail::TimeAwaiter sleepFor( std::chrono::duration<Rep, Period> d ) {
+	  return until( Clock::now() +
+					std::chrono::duration_cast<Clock::duration>( d ) );
+	}
+
+	detail::ReadableAwaiter readable( int fd ) {
+	  return detail::ReadableAwaiter{ thiz, fd, false, {} };
+	}
+
+#endif
+
+	// For mixing with the C API, e.g. executiveTimeoutQueue
+	::Executive* get() const {
+	  return thiz;
+	}
+
+  private:
+	::Executive* thiz;
+  };
+}
+
+#endif
+
+// eof
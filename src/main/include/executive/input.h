@@ -0,0 +1,114 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_INPUT_H
+#define _EXECUTIVE_INPUT_H
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	Buffered, framed input on an fd watched by an Executive's run loop
+	(see loop.h).  Rather than each app reading into a stack buffer
+	and reassembling partial lines itself, an ExecutiveInput reads
+	(one readv per wakeup) into a ring buffer, splits the data into
+	records and hands each complete record to an InputAction as a
+	slice of that buffer: no copying.  All records completed by one
+	read are delivered in one go.
+
+	Two framings are supported:
+
+	+ delimited: records end with a delimiter byte, e.g. '\n' for
+	  lines.  The delimiter is not part of the record.
+
+	+ length-prefixed: each record is preceded by its length, as a 1,
+	  2 or 4 byte big-endian (network order) unsigned integer.  The
+	  prefix is not part of the record.
+
+	Ring buffers are recycled via a small per-Executive pool.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct ExecutiveInput;
+  typedef struct ExecutiveInput ExecutiveInput;
+
+  /**
+   * Called once per record.  The record is valid only for the
+   * duration of the call.  At eof, after any final undelimited
+   * record, the action is called once more with record NULL and errno
+   * 0. On error, including a record longer than maxRecord, likewise
+   * but with errno set.  Either way the fd is then no longer watched,
+   * and the ExecutiveInput should be freed.  It may be freed from
+   * within the action itself, at any time.
+   */
+  typedef void (*InputAction)( ExecutiveInput* in,
+							   const char* record, size_t length,
+							   void* env );
+
+  /**
+   * @param maxRecord - longest record accepted. The ring buffer is a
+   * little more than twice this.
+   *
+   * @return new input, with fd now watched, or NULL on error
+   */
+  ExecutiveInput* executiveInputDelimited( Executive* e, int fd,
+										   char delimiter, size_t maxRecord,
+										   InputAction action, void* env );
+
+  /**
+   * @param prefixSize - 1, 2 or 4
+   */
+  ExecutiveInput* executiveInputPrefixed( Executive* e, int fd,
+										  unsigned prefixSize,
+										  size_t maxRecord,
+										  InputAction action, void* env );
+
+  /**
+   * Unwatch the fd (which is NOT closed) and release the input.
+   */
+  void executiveInputFree( ExecutiveInput* in );
+
+  int executiveInputFd( ExecutiveInput* in );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
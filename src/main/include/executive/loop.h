@@ -0,0 +1,185 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_LOOP_H
+#define _EXECUTIVE_LOOP_H
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	A ready-made main loop for an Executive, so that apps need not
+	hand-write the select loop described in executive.h.  Time and
+	I/O are multiplexed exactly as there: wait on all watched fds
+	until the head Event's time, then either fire due Events or
+	service ready fds.
+
+	Fd readiness is delivered to an Action, just as for a timed Event.
+	The Event passed has the watching Executive, the env given when
+	watching, and 'now' as both its scheduled and actual times.  That
+	Event exists only for the duration of the Action call, so must not
+	be retained, cancelled or re-added.
+
+	E = executiveNew();
+	executiveAdd( E, some event(s) ... );
+	executiveWatchFd( E, STDIN_FILENO, stdinAction, env );
+	executiveRun( E );
+
+	The loop waits via ppoll (Linux) or poll, so has no FD_SETSIZE
+	limit. Its own state is allocated when first needed, and freed
+	along with the Executive.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * Call 'action' whenever fd is readable (or at eof/error).  Any
+   * previous watch on fd is replaced.
+   *
+   * @return 0 on success, -1 if out of memory
+   */
+  int executiveWatchFd( Executive* e, int fd, Action action, void* env );
+
+  /**
+   * Stop watching fd for readability. Safe to call from within any
+   * Action, including that of fd itself.  Unwatch an fd before
+   * closing it: one closed while still watched is dropped only if the
+   * loop sees it invalid before its number is reused by a new fd.
+   *
+   * @return 0 if fd was watched, else -1
+   */
+  int executiveUnwatchFd( Executive* e, int fd );
+
+  /**
+   * Call 'action' whenever fd is writable (or at error), independently
+   * of any readability watch on the same fd.  Typically wanted only
+   * while output is backed up, see output.h, which does this itself.
+   *
+   * @return 0 on success, -1 if out of memory
+   */
+  int executiveWatchFdWritable( Executive* e, int fd,
+								Action action, void* env );
+
+  /**
+   * @return 0 if fd was watched for writability, else -1
+   */
+  int executiveUnwatchFdWritable( Executive* e, int fd );
+
+  /**
+   * Call 'action' when signal signo arrives, in place of any signal
+   * handler.  The signal is blocked, and read instead from a signalfd
+   * watched by the loop, so Actions run in normal (not signal handler)
+   * context, and no wait is interrupted.  All signals arriving between
+   * wakeups are handled in one, each watched signal's Action being
+   * called just once however many times it arrived.
+   *
+   * Signals are blocked in the calling thread via pthread_sigmask, so
+   * watch them before creating any threads, which then inherit the
+   * block.  Threads this library creates, parallel workers
+   * (parallel.h) and watchdogs (watchdog.h), block all signals, so
+   * may be created at any time.  Linux only (signalfd).
+   *
+   * @return 0 on success, -1 on error (see errno, ENOSYS off Linux)
+   */
+  int executiveWatchSignal( Executive* e, int signo,
+							Action action, void* env );
+
+  /**
+   * Stop watching signo, unblocking it if we blocked it.
+   *
+   * @return 0 if signo was watched, else -1
+   */
+  int executiveUnwatchSignal( Executive* e, int signo );
+
+  /**
+   * One iteration of the loop: flush any queued output (see
+   * output.h), then fire all Events already due, else wait for the
+   * head Event's time or fd readiness, whichever comes first, and act
+   * accordingly. A wait interrupted by a signal is not an
+   * error.
+   *
+   * @return 1 if the loop should go on, 0 if there is nothing left to
+   * do (no Events and no watched fds), -1 on error (see errno)
+   */
+  int executiveRunOnce( Executive* e );
+
+  /**
+   * Iterate until executiveStop is called (typically from some
+   * Action), there is nothing left to do, or an error.
+   *
+   * @return 0, or -1 on error (see errno)
+   */
+  int executiveRun( Executive* e );
+
+  void executiveStop( Executive* e );
+
+  /**
+   * Discrete-event simulation: run on a virtual clock, never sleeping
+   * nor consulting the real one.  Time jumps straight from one Event's
+   * scheduledTime to the next, each fired with that time as its
+   * actualTime, until no Event remains at or before 'until', or
+   * executiveStop is called.  Watched fds and signals play no part.
+   *
+   * For hours of timers to replay in milliseconds, and repeatably,
+   * Actions must take 'now' from their actualTime argument, never
+   * from gettimeofday.
+   *
+   * @return number of Events fired
+   */
+  size_t executiveRunSimulated( Executive* e, struct timeval* until );
+
+  /**
+   * Low-latency mode. A blocking wait can overshoot its timeout by the
+   * kernel's timer slack (50µs by default on Linux), too coarse for
+   * e.g. pacing output. With a spin threshold set, the loop blocks
+   * only until 'threshold' short of the head Event's time, then
+   * busy-polls the clock and fds for the rest, firing the Event on
+   * time at the cost of a CPU kept busy meanwhile.
+   *
+   * @param threshold - e.g. 100µs, or NULL (the default) never to spin
+   *
+   * @return 0, or -1 if no memory for the loop state
+   */
+  int executiveSetSpin( Executive* e, struct timeval* threshold );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
@@ -0,0 +1,133 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_OUTPUT_H
+#define _EXECUTIVE_OUTPUT_H
+
+#include <sys/types.h>
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	Queued, vectored output on an fd, written by an Executive's run
+	loop (see loop.h).  Rather than each Action making its own write
+	call for its few bytes, Actions enqueue them on an ExecutiveOutput,
+	and the loop, before it next waits, hands everything queued on
+	that fd to one writev.  Should the fd not take it all (EAGAIN, or
+	a short write), the rest waits for the fd to become writable.
+
+	Bytes are enqueued either by copy, into buffers shared by
+	consecutive small writes (recycled via the same per-Executive pool
+	as input.h's), or by reference, the caller's buffer being released
+	via a callback once written.
+
+	The fd should be non-blocking, else a slow reader stalls the whole
+	loop. Writing to a closed socket or pipe raises SIGPIPE, which
+	servers will want ignored.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct ExecutiveOutput;
+  typedef struct ExecutiveOutput ExecutiveOutput;
+
+  /**
+   * @return new output queue for fd, or NULL if out of memory
+   */
+  ExecutiveOutput* executiveOutputNew( Executive* e, int fd );
+
+  /**
+   * Enqueue a copy of 'length' bytes of data.
+   *
+   * @return 0, or -1 if out of memory or the fd is in error (errno
+   * then as per the failed write)
+   */
+  int executiveOutputWrite( ExecutiveOutput* out,
+							const void* data, size_t length );
+
+  /**
+   * Enqueue 'length' bytes of data, by reference, so no copy. The data
+   * must stay put until release( arg ) is called, once it is written
+   * or discarded.  A NULL release is allowed, for static data.  On
+   * failure, release is called before returning.
+   *
+   * @return 0, or -1 as per executiveOutputWrite
+   */
+  int executiveOutputWriteRef( ExecutiveOutput* out,
+							   const void* data, size_t length,
+							   void (*release)( void* arg ), void* arg );
+
+  /**
+   * Write what can be written now, without waiting for the loop.
+   *
+   * @return bytes still pending, or -1 if the fd is in error
+   */
+  ssize_t executiveOutputFlush( ExecutiveOutput* out );
+
+  /**
+   * @return bytes enqueued but not yet written
+   */
+  size_t executiveOutputPending( ExecutiveOutput* out );
+
+  /**
+   * Call drained( out, arg ) whenever output that had backed up, so
+   * was awaiting writability, is then all written.  For producers that
+   * pause while executiveOutputPending is large.  NULL for no call.
+   * The queue may be freed from within drained.
+   */
+  void executiveOutputSetDrained( ExecutiveOutput* out,
+								  void (*drained)( ExecutiveOutput* out,
+												   void* arg ),
+								  void* arg );
+
+  /**
+   * Discard any output pending, releasing references, and free the
+   * queue.  The fd is NOT closed.  Free all queues before their
+   * Executive.
+   */
+  void executiveOutputFree( ExecutiveOutput* out );
+
+  int executiveOutputFd( ExecutiveOutput* out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
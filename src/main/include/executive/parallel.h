@@ -0,0 +1,125 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_PARALLEL_H
+#define _EXECUTIVE_PARALLEL_H
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	Parallel firing.  When many Events come due together (expiry
+	storms on the hour, say), executiveFire runs their Actions one by
+	one, on one core.  Instead, a batch of due Events can be handed
+	to a pool of worker threads.
+
+	Each Event has a 'conflict key', by default its env.  Events with
+	the same key all go to the same worker, and so run one at a time,
+	in scheduled order.  Events with distinct keys may run in
+	parallel, so their Actions must not share unguarded state.  The
+	caller waits for the whole batch to complete (a barrier) before
+	the next batch can start.
+
+	While a batch runs, Actions may add, touch and cancel/clear Events
+	on the Executive (or its children) as usual, locate timeout queues,
+	and migrate/merge Events, such changes then being serialized by a
+	lock.  They must not peek/fire it, nor free it.
+
+	All else attached to an Executive is NOT so locked: its run loop
+	(loop.h, so watched fds and signals), input (input.h) and output
+	(output.h) streams, TCP listeners and connections (tcp.h),
+	debounced and throttled keys (debounce.h), rate limiters (rate.h)
+	and schedules (schedule.h).  Actions fired in parallel must not
+	call any of these.  The last four also fire Events of their own,
+	which touch that state, so an Executive using any of them must not
+	be fired in parallel at all.
+
+	Nor are Actions fired in parallel profiled (profile.h) or watched
+	(watchdog.h).
+
+	The conflict key concept, and so the ordering guarantee, is for
+	Actions.  Events due after the batch was formed, including any
+	added by its Actions, go in a later batch.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct ExecutiveWorkers;
+  typedef struct ExecutiveWorkers ExecutiveWorkers;
+
+  /**
+   * Start 'threads' worker threads, idle until given a batch.
+   *
+   * @param key - maps an Event to its conflict key, NULL for its env
+   *
+   * @return the pool, or NULL on failure (see errno)
+   */
+  ExecutiveWorkers* executiveWorkersNew( size_t threads,
+										 void* (*key)( Event* e ) );
+
+  /**
+   * Stop and join the worker threads. Not while a batch is running.
+   */
+  void executiveWorkersFree( ExecutiveWorkers* w );
+
+  /**
+   * Fire all Events due by 'now', with 'now' as their actualTime, on
+   * the workers, and wait until all have done so.  Those due Events
+   * already pending when called are fired, not any added meanwhile.
+   *
+   * @return number of Events fired, or EXECUTIVE_FULL if no memory
+   * for the batch, in which case none were.
+   */
+  size_t executiveFireParallel( Executive* e, struct timeval* now,
+								ExecutiveWorkers* w );
+
+  /**
+   * Opt-in for the run loop (loop.h): due Events are then fired via
+   * executiveFireParallel on 'w', rather than one by one.  NULL to
+   * opt out again.  The workers are not owned by the Executive.
+   *
+   * @return 0, or -1 if no memory for the loop state
+   */
+  int executiveSetWorkers( Executive* e, ExecutiveWorkers* w );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
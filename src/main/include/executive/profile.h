@@ -0,0 +1,105 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_PROFILE_H
+#define _EXECUTIVE_PROFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	Per-Action profiling, to find which Action is keeping a busy loop
+	busy.  Once started, each Action called by executiveFire is timed,
+	in wall-clock time and in CPU time of the calling thread, the
+	figures accumulating per Action (function pointer, so all Events
+	sharing an Action share its figures).  Fd and signal Actions, and
+	Events fired on worker threads (see parallel.h), are not timed.
+
+	The cost, two pairs of clock_gettime calls and a hash lookup per
+	Event fired, is paid only while profiling.
+
+	Names in the report are found via dladdr, so only for functions
+	visible to the dynamic linker: link with -rdynamic for those in
+	the executable itself.  Static functions appear as file+offset.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef struct ExecutiveProfileStats {
+	uint64_t calls;
+	// all nanoseconds
+	uint64_t wallTotal;
+	uint64_t wallMax;
+	uint64_t cpuTotal;
+	uint64_t cpuMax;
+  } ExecutiveProfileStats;
+
+  /**
+   * Start profiling, from zero.
+   *
+   * @return 0, or -1 if out of memory
+   */
+  int executiveProfileStart( Executive* e );
+
+  /**
+   * Stop profiling, discarding all figures.
+   */
+  void executiveProfileStop( Executive* e );
+
+  /**
+   * @return true, and a's figures in 'result', if a has been called
+   * while profiling
+   */
+  bool executiveProfileGet( Executive* e, Action a,
+							ExecutiveProfileStats* result );
+
+  /**
+   * Print the 'topN' Actions by total CPU time, one per line, with
+   * their figures (in microseconds), most CPU first.
+   */
+  void executiveProfileReport( Executive* e, FILE* f, size_t topN );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
@@ -0,0 +1,128 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_RATE_H
+#define _EXECUTIVE_RATE_H
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	Rate limiting and pacing.  An ExecutiveRateLimiter is a token
+	bucket: a token is earned every 'interval', up to 'burst' of them
+	saved up, and each acquire spends one.  It is kept as the one time
+	at which the bucket would next be empty (the 'generic cell rate
+	algorithm'), so no timer is needed just to earn tokens.
+
+	Callers either try for a token, and are told at once, or queue for
+	one, their Action being called once it is theirs.  However many are
+	queued, the limiter has at most one Event pending, for when the
+	first in the queue can go.  With burst 1, waiters go exactly
+	'interval' apart: pacing.
+
+	Should the limiter be unable to re-add its Event, to wait for the
+	next token, the Executive being full (EXECUTIVE_FULL, see
+	executiveSetLimits), waiters are not left stranded: each still
+	queued has its Action called at once, but denied, as
+	executiveRateLimiterDenied then says.
+
+	Times given are 'now', as per executiveTimeoutAdd.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct ExecutiveRateLimiter;
+  typedef struct ExecutiveRateLimiter ExecutiveRateLimiter;
+
+  /**
+   * @param interval - time to earn one token
+   * @param burst - most tokens held, at least 1. A new limiter is full.
+   *
+   * @return new limiter, or NULL if out of memory, or burst 0 (errno
+   * EINVAL)
+   */
+  ExecutiveRateLimiter* executiveRateLimiterNew( Executive* e,
+												 struct timeval* interval,
+												 unsigned burst );
+
+  /**
+   * Discard the limiter, and any queued waiters, whose Actions are
+   * NOT called.  May be called from a waiter's Action.
+   */
+  void executiveRateLimiterFree( ExecutiveRateLimiter* l );
+
+  /**
+   * Take a token, if one is available, and none are queued for.
+   *
+   * @return true if taken
+   */
+  bool executiveRateLimiterTryAcquire( ExecutiveRateLimiter* l,
+									   struct timeval* now );
+
+  /**
+   * Queue for a token, FIFO.  Once it is ours, the Action is called,
+   * from the limiter's Event, with 'env' as the Event's env.  This is
+   * so even if a token is available now.  The Action is also called
+   * should the token be denied, see above.
+   *
+   * @return 0, or -1 if out of memory, or the Executive is full
+   * (always so from a denied waiter's Action)
+   */
+  int executiveRateLimiterAcquireAsync( ExecutiveRateLimiter* l,
+										struct timeval* now,
+										Action action, void* env );
+
+  /**
+   * @return number of waiters queued
+   */
+  size_t executiveRateLimiterWaiting( ExecutiveRateLimiter* l );
+
+  /**
+   * From within a waiter's Action: was it called with a token, or
+   * denied one?
+   *
+   * @return true if denied
+   */
+  bool executiveRateLimiterDenied( ExecutiveRateLimiter* l );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
@@ -0,0 +1,115 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_SCHEDULE_H
+#define _EXECUTIVE_SCHEDULE_H
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	Calendar ('cron') schedules.  Rather than an Action recomputing
+	its own next wall-clock time, a schedule is given as a crontab(5)
+	style spec, compiled once into a matcher.  Each schedule has just
+	the one Event pending at any time, for its next occurrence,
+	computed only once the previous has fired.  The Event lives inside
+	the schedule, so firing costs no allocation.
+
+	A spec has five fields, minute (0-59), hour (0-23), day of month
+	(1-31), month (1-12) and day of week (0-7, 0 and 7 both Sunday),
+	each a comma-separated list of '*', 'n' or 'n-m', any of which may
+	be followed by '/step'.  As in cron, when both day fields are
+	restricted, a day matching either will do.  Again as cron, a field
+	starting '*', even with a '/step', counts as unrestricted here, so
+	odd days of month with day of week 1 means odd-numbered Mondays,
+	not odd days plus all Mondays.  The shorthands @hourly, @daily
+	(@midnight), @weekly, @monthly and @yearly (@annually) are also
+	accepted.
+
+	"0-59/15 * * * *" every 15 minutes, at :00, :15, :30 and :45
+	"0 2 * * *"       daily at 02:00
+	"30 9 * * 1-5"    weekdays at 09:30
+
+	Times are local, as per the TZ environment variable (see tzset),
+	so one zone for all schedules.  Through a DST change, occurrences
+	in a skipped hour happen an hour later, and those in a repeated
+	hour happen once.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct ExecutiveSchedule;
+  typedef struct ExecutiveSchedule ExecutiveSchedule;
+
+  /**
+   * Call 'action' at each time matching cronSpec, the first being the
+   * first such time after 'now', the Executive's idea of now, so a
+   * virtual time under executiveRunSimulated.  The Event passed to the
+   * action has the occurrence's time as its scheduledTime, and 'env'
+   * as its env.
+   *
+   * The schedule lasts until cancelled, or its Executive is cleared or
+   * freed.
+   *
+   * @return the schedule, or NULL if cronSpec is invalid (errno
+   * EINVAL), never matches, or no memory.
+   */
+  ExecutiveSchedule* executiveAddSchedule( Executive* e, const char* cronSpec,
+										   struct timeval* now,
+										   Action action, void* env );
+
+  /**
+   * Stop, and free, a schedule.  May be called from within its own
+   * action.
+   */
+  void executiveScheduleCancel( ExecutiveSchedule* s );
+
+  /**
+   * The first time matching the schedule strictly after 'after'.
+   *
+   * @return false if there is none within the next few years
+   */
+  bool executiveScheduleNext( ExecutiveSchedule* s, struct timeval* after,
+							  struct timeval* result );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
@@ -0,0 +1,167 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_SHARED_H
+#define _EXECUTIVE_SHARED_H
+
+#include <stdint.h>
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	An Executive shared between processes, e.g. pre-forked workers
+	scheduling and cancelling cluster-wide timers such as lease
+	expiries.  It lives in a POSIX shared memory object (shm_open),
+	mapped by each process, maybe at differing addresses, so Events
+	are linked by slot index, not pointer.  Its capacity, and the size
+	of each Event's env, are fixed when it is created.
+
+	Function pointers mean nothing in another process, so an Event
+	carries a small integer 'kind' instead, plus its env, copied into
+	the shared region.  Each process maps kinds to Actions of its own.
+	The Event passed to an Action has a private copy of the env, and no
+	Executive.
+
+	Any process may add and cancel.  Processes wanting to fire Events
+	call executiveSharedRunOnce, which waits (on a futex in the
+	region) until the earliest Event is due, or a timeout.  An earlier
+	Event added wakes just one waiting process, which waits on for
+	that, and passes the wake on to another when it returns.  Each
+	Event is fired by just one process, whichever takes it first.  Access is serialized by a robust, process-shared
+	mutex, so a process dying while holding it blocks no others.
+
+	Linux only (futex, robust mutexes).  Elsewhere, creating or
+	opening fails with ENOSYS.
+
+	S = executiveSharedCreate( "/leases", 1024, 64 );
+	fork() ...
+	executiveSharedSetAction( S, LEASE_EXPIRED, leaseExpired );
+	while( running )
+	  executiveSharedRunOnce( S, NULL );
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct ExecutiveShared;
+  typedef struct ExecutiveShared ExecutiveShared;
+
+  /**
+   * Identifies an Event added, for cancelling.  Never 0, so 0 can
+   * signal failure.  A stale id (its Event fired or cancelled) is
+   * harmless.
+   */
+  typedef uint64_t ExecutiveSharedId;
+
+  // Kinds are 0 to this, less one
+#define EXECUTIVE_SHARED_KINDS 64
+
+  /**
+   * Create the shared memory object 'name' (see shm_open), which must
+   * not already exist, and map it.  Children forked afterwards may use
+   * the result as is.
+   *
+   * @param capacity - most Events pending at once
+   * @param envSize - most bytes of env per Event
+   *
+   * @return NULL on error, see errno
+   */
+  ExecutiveShared* executiveSharedCreate( const char* name, size_t capacity,
+										  size_t envSize );
+
+  /**
+   * Map an existing shared Executive, as made by executiveSharedCreate.
+   *
+   * @return NULL on error, see errno
+   */
+  ExecutiveShared* executiveSharedOpen( const char* name );
+
+  /**
+   * Unmap, in this process only.  The Events stay, for other
+   * processes.
+   */
+  void executiveSharedClose( ExecutiveShared* s );
+
+  /**
+   * Remove the name, as shm_unlink.  The memory goes once every
+   * process has closed it.
+   */
+  int executiveSharedUnlink( const char* name );
+
+  /**
+   * Add an Event, of 'kind', with a copy of envSize bytes of env
+   * (envSize at most that given at creation).
+   *
+   * @return id, or 0 if full, or kind or envSize are out of range
+   */
+  ExecutiveSharedId executiveSharedAdd( ExecutiveShared* s,
+										struct timeval* scheduledTime,
+										unsigned kind,
+										const void* env, size_t envSize );
+
+  /**
+   * @return 0 if cancelled, -1 if the Event is already gone
+   */
+  int executiveSharedCancel( ExecutiveShared* s, ExecutiveSharedId id );
+
+  size_t executiveSharedLength( ExecutiveShared* s );
+
+  /**
+   * In this process, call 'action' for Events of 'kind'.  Events of a
+   * kind with no Action are fired, and discarded.
+   *
+   * @return 0, or -1 if kind is out of range
+   */
+  int executiveSharedSetAction( ExecutiveShared* s, unsigned kind,
+								Action action );
+
+  /**
+   * Fire all Events already due, else wait until one is (or for at
+   * most 'timeout', if not NULL) and fire those then due.  A wait
+   * interrupted by a signal returns early.
+   *
+   * @return number of Events this process fired, or -1 on error
+   */
+  int executiveSharedRunOnce( ExecutiveShared* s, struct timeval* timeout );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
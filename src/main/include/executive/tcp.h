@@ -0,0 +1,206 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_TCP_H
+#define _EXECUTIVE_TCP_H
+
+#include <sys/time.h>
+
+#include "executive/executive.h"
+#include "executive/output.h"
+
+/**
+	@author Stuart Maclean
+
+	TCP servers on an Executive's run loop (see loop.h).  An
+	ExecutiveListener accepts, non-blocking, up to
+	EXECUTIVE_ACCEPT_BATCH connections per wakeup (accept4 on Linux),
+	handing each to an AcceptAction as an ExecutiveConnection.  That
+	then reads, one read per wakeup, into a ConnectionReadAction, and
+	writes via an ExecutiveOutput (see output.h), so that all a
+	connection's writes between wakeups go in one writev.
+
+	A listener may give its connections an idle timeout: any not
+	having sent anything for that long are closed.  The timeouts share
+	one timeout queue (see executive.h), so arming, re-arming on each
+	read, and cancelling on close are all O(1).
+
+	To spread connections over several Executives, one per thread (the
+	'shards'), each creates its own listener on the same port with
+	EXECUTIVE_LISTEN_REUSEPORT, and the kernel balances incoming
+	connections among them (Linux, the BSDs).
+
+	Writing to a connection closed by the peer raises SIGPIPE, which
+	servers will want ignored.  Free listeners, and close connections,
+	before their Executive.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct ExecutiveListener;
+  typedef struct ExecutiveListener ExecutiveListener;
+
+  struct ExecutiveConnection;
+  typedef struct ExecutiveConnection ExecutiveConnection;
+
+  // Most connections accepted per wakeup, so others' fds are not starved
+#define EXECUTIVE_ACCEPT_BATCH 64
+
+  // executiveListenerNew flags
+#define EXECUTIVE_LISTEN_REUSEPORT 1
+
+  /**
+   * Called once per accepted connection, typically to call
+   * executiveConnectionSetActions.  'now' is as per the Action
+   * watching the listener.
+   */
+  typedef void (*AcceptAction)( ExecutiveListener* l, ExecutiveConnection* c,
+								struct timeval* now, void* env );
+
+  /**
+   * Called once per read.  The data is valid only for the duration of
+   * the call, and need not be a whole message, nor only one.
+   */
+  typedef void (*ConnectionReadAction)( ExecutiveConnection* c,
+										const char* data, size_t length,
+										void* env );
+
+  /**
+   * Called when output that had backed up is all written, see
+   * executiveOutputSetDrained.
+   */
+  typedef void (*ConnectionWriteAction)( ExecutiveConnection* c, void* env );
+
+  /**
+   * Called when the peer closes the connection (error 0), on error
+   * (errno value), or at the idle timeout (ETIMEDOUT).  The connection
+   * is freed once this returns.
+   */
+  typedef void (*ConnectionCloseAction)( ExecutiveConnection* c, int error,
+										 void* env );
+
+  /**
+   * Listen on host (numeric or by name, NULL for all interfaces) and
+   * port (0 for any, see executiveListenerPort).
+   *
+   * @param flags - 0, or EXECUTIVE_LISTEN_REUSEPORT
+   *
+   * @return new listener, its fd now watched, or NULL on error (see
+   * errno)
+   */
+  ExecutiveListener* executiveListenerNew( Executive* e, const char* host,
+										   unsigned short port, int flags,
+										   AcceptAction accept, void* env );
+
+  /**
+   * Give connections accepted from now on an idle timeout, or none if
+   * idle is NULL (the default).
+   *
+   * @return 0, or -1 if out of memory
+   */
+  int executiveListenerSetIdle( ExecutiveListener* l, struct timeval* idle );
+
+  /**
+   * @return the port actually bound
+   */
+  unsigned short executiveListenerPort( ExecutiveListener* l );
+
+  /**
+   * @return connections accepted so far
+   */
+  size_t executiveListenerAccepted( ExecutiveListener* l );
+
+  int executiveListenerFd( ExecutiveListener* l );
+
+  /**
+   * Stop listening, closing the listening socket.  Connections already
+   * accepted are unaffected.  Safe to call from within the AcceptAction.
+   */
+  void executiveListenerFree( ExecutiveListener* l );
+
+  /**
+   * A connection on some already connected socket, e.g. a client's.
+   * The fd is made non-blocking and watched, and is closed along with
+   * the connection.
+   *
+   * @param idle - idle timeout, from 'now', or NULL for none
+   *
+   * @return new connection, or NULL on error (see errno)
+   */
+  ExecutiveConnection* executiveConnectionNew( Executive* e, int fd,
+											   struct timeval* idle,
+											   struct timeval* now );
+
+  /**
+   * Any action may be NULL, data read then being discarded.
+   */
+  void executiveConnectionSetActions( ExecutiveConnection* c,
+									  ConnectionReadAction read,
+									  ConnectionWriteAction write,
+									  ConnectionCloseAction close,
+									  void* env );
+
+  /**
+   * Enqueue a copy of data, as per executiveOutputWrite.
+   *
+   * @return 0, or -1 on error (see errno)
+   */
+  int executiveConnectionWrite( ExecutiveConnection* c,
+								const void* data, size_t length );
+
+  /**
+   * For writes by reference, pending counts, etc. Do not free it, nor
+   * set its drained callback, see ConnectionWriteAction instead.
+   */
+  ExecutiveOutput* executiveConnectionOutput( ExecutiveConnection* c );
+
+  /**
+   * Write what output can be written at once, then close and free the
+   * connection, cancelling its idle timeout. The ConnectionCloseAction
+   * is not called.  Safe to call from within any of the connection's
+   * actions.
+   */
+  void executiveConnectionClose( ExecutiveConnection* c );
+
+  int executiveConnectionFd( ExecutiveConnection* c );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
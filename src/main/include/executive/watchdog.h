@@ -0,0 +1,125 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#ifndef _EXECUTIVE_WATCHDOG_H
+#define _EXECUTIVE_WATCHDOG_H
+
+#include <signal.h>
+
+#include "executive/executive.h"
+
+/**
+	@author Stuart Maclean
+
+	A watchdog for Actions overrunning, since one Action blocking for
+	200ms delays every other Event by as much.  A watchdog is a thread
+	of its own, checking, some eight times per 'budget', which Action
+	(if any) its Executive is firing.  An Action found to be still
+	firing after budget is reported, just once, with a sample of the
+	firing thread's stack.
+
+	All the fire path does, while watched, is publish the Event being
+	fired and then clear it, as a seqlock: a release fence, stores of
+	the Action and scheduled time (three words) and then a serial
+	number, and a store clearing that serial afterwards.  Five atomic
+	stores, relaxed bar the serial's, so on x86 plain moves, the fence
+	merely ordering the compiler.  No clock reads: overruns are timed
+	by the watchdog, to within budget/8.
+
+	The stack is sampled by signalling the firing thread with
+	EXECUTIVE_WATCHDOG_SIGNAL, so a watchdog must be created by the
+	thread that runs (fires) the Executive, and an Action sampled may
+	see a system call interrupted (EINTR).  Fired on worker threads
+	(see parallel.h), Actions are not watched.
+
+	The first watchdog installs a handler for that signal, process
+	wide.  Any handler installed before is called for signals other
+	than the watchdog's own, e.g. out-of-band data on a socket, but
+	one installed after displaces the watchdog's, so its samples are
+	then empty.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXECUTIVE_WATCHDOG_SIGNAL SIGURG
+
+  // Most frames in a stack sample
+#define EXECUTIVE_WATCHDOG_STACK 32
+
+  typedef struct ExecutiveOverrun {
+	Executive* executive;
+	Action action;
+	struct timeval scheduledTime;
+	// so far, the Action may yet run on
+	struct timeval elapsed;
+	void* stack[EXECUTIVE_WATCHDOG_STACK];
+	int stackDepth;
+  } ExecutiveOverrun;
+
+  /**
+   * Called, on the watchdog thread, once per Action overrunning.
+   */
+  typedef void (*OverrunAction)( ExecutiveOverrun* o, void* arg );
+
+  struct ExecutiveWatchdog;
+  typedef struct ExecutiveWatchdog ExecutiveWatchdog;
+
+  /**
+   * Watch e's Actions, one watchdog per Executive.
+   *
+   * @param report - NULL to print each overrun, with its stack, to
+   * stderr
+   *
+   * @return new watchdog, its thread started, or NULL on error (errno
+   * EBUSY if e already has one)
+   */
+  ExecutiveWatchdog* executiveWatchdogNew( Executive* e,
+										   struct timeval* budget,
+										   OverrunAction report,
+										   void* arg );
+
+  /**
+   * Stop, and join, the watchdog thread.  Also done by executiveFree.
+   */
+  void executiveWatchdogFree( ExecutiveWatchdog* w );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// eof
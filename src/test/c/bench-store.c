@@ -0,0 +1,203 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "executive/executive.h"
+
+/**
+ * @author Stuart Maclean
+ *
+ * How fast is an Executive's store, i.e. the time-ordered set of
+ * pending Events?  This one program is linked against each library,
+ * so against each store in turn:
+ *
+ * bench-store-list - libexecutive.a, the intrusive list
+ *
+ * bench-store-radix - libexecutive-radix.a, the radix heap
+ *
+ * bench-store-glib - libexecutive-glib.a, the GLib GList (if built)
+ *
+ * For each of several numbers of pending Events, n, the workloads are:
+ *
+ * hold - the classic 'hold' model of timer use: fire the head Event,
+ * whose Action re-adds it at a random delay (up to n ms) after the
+ * time fired, so all times are monotone.
+ *
+ * hold+late - as hold, but 1 in 100 re-adds is instead some time
+ * before that fired, the radix heap's worst case.
+ *
+ * fill+drain - add n Events at random times, then fire them all.
+ *
+ * Each prints the mean ns per Event fired (and so re-added). The same
+ * random sequence is used whichever the store, so that results compare.
+ *
+ * Usage: bench-store-{list,radix,glib} [firingsPerRun]
+ */
+
+typedef enum { HOLD, HOLD_LATE, FILL_DRAIN, WORKLOADS } Workload;
+
+static const char* workloadNames[WORKLOADS] = {
+  "hold", "hold+late", "fill+drain"
+};
+
+static const size_t sizes[] = { 100, 1000, 10000 };
+
+static uint64_t seed;
+
+// xorshift64, cheap and identical on all platforms
+static uint64_t nextRandom(void) {
+  seed ^= seed << 13;
+  seed ^= seed >> 7;
+  seed ^= seed << 17;
+  return seed;
+}
+
+static size_t pending;
+static int lateEvery;
+
+static struct timeval randomDelay(void) {
+  uint64_t us = nextRandom() % (pending * 1000) + 1;
+  struct timeval result = { (time_t)(us / 1000000),
+							(suseconds_t)(us % 1000000) };
+  return result;
+}
+
+static void execActionHold( Event* e, struct timeval* actualTime ) {
+  struct timeval delay = randomDelay();
+  struct timeval next;
+  if( lateEvery && nextRandom() % lateEvery == 0 &&
+	  timercmp( actualTime, &delay, > ) )
+	timersub( actualTime, &delay, &next );
+  else
+	timeradd( actualTime, &delay, &next );
+  executiveAdd( executiveEventExecutive( e ), &next, execActionHold );
+}
+
+static void execActionNop( Event* e, struct timeval* actualTime ) {
+  (void)e;
+  (void)actualTime;
+}
+
+static double elapsedNs( struct timespec* from ) {
+  struct timespec to;
+  clock_gettime( CLOCK_MONOTONIC, &to );
+  return (to.tv_sec - from->tv_sec) * 1e9 + (to.tv_nsec - from->tv_nsec);
+}
+
+// Fire the head Event, at its scheduled time
+static void fireHead( Executive* E ) {
+  struct timeval now = *executivePeek( E );
+  executiveFire( E, &now );
+}
+
+// Returns mean ns per Event fired, or < 0 on failure
+static double run( Workload w, size_t n, size_t firings ) {
+  Executive* E = executiveNew();
+  if( !E )
+	return -1;
+  seed = 88172645463325252ULL;
+  pending = n;
+  lateEvery = w == HOLD_LATE ? 100 : 0;
+
+  // An epoch well after 0, so late re-adds stay positive
+  struct timeval start = { 1000000, 0 };
+  double result = -1;
+  if( w == FILL_DRAIN ) {
+	struct timespec t0;
+	clock_gettime( CLOCK_MONOTONIC, &t0 );
+	size_t fired = 0;
+	while( fired < firings ) {
+	  for( size_t i = 0; i < n; i++ ) {
+		struct timeval delay = randomDelay(), when;
+		timeradd( &start, &delay, &when );
+		executiveAdd( E, &when, execActionNop );
+	  }
+	  while( executiveLength( E ) )
+		fireHead( E );
+	  fired += n;
+	  start.tv_sec += n;
+	}
+	result = elapsedNs( &t0 ) / fired;
+  } else {
+	for( size_t i = 0; i < n; i++ ) {
+	  struct timeval delay = randomDelay(), when;
+	  timeradd( &start, &delay, &when );
+	  executiveAdd( E, &when, execActionHold );
+	}
+	// warm up, so the times are spread as in steady state
+	for( size_t i = 0; i < n; i++ )
+	  fireHead( E );
+	struct timespec t0;
+	clock_gettime( CLOCK_MONOTONIC, &t0 );
+	for( size_t i = 0; i < firings; i++ )
+	  fireHead( E );
+	result = elapsedNs( &t0 ) / firings;
+  }
+  executiveFree( E );
+  return result;
+}
+
+int main( int argc, char* argv[] ) {
+
+  size_t firings = argc > 1 ? strtoul( argv[1], NULL, 10 ) : 50000;
+  if( firings < 1 )
+	firings = 1;
+
+  const char* store = strrchr( argv[0], '/' );
+  store = store ? store + 1 : argv[0];
+
+  printf( "%-20s %-12s %8s %10s\n", "store", "workload", "n", "ns/op" );
+  for( Workload w = 0; w < WORKLOADS; w++ ) {
+	for( size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ ) {
+	  double ns = run( w, sizes[i], firings );
+	  if( ns < 0 ) {
+		printf( "%-20s %-12s %8zu %10s\n", store, workloadNames[w],
+				sizes[i], "failed" );
+		return 1;
+	  }
+	  printf( "%-20s %-12s %8zu %10.1f\n", store, workloadNames[w],
+			  sizes[i], ns );
+	  fflush( stdout );
+	}
+  }
+  return 0;
+}
+
+// eof
@@ -0,0 +1,280 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "executive/loop.h"
+#include "executive/tcp.h"
+
+/**
+ * @author Stuart Maclean
+ *
+ * A loopback load test of tcp.h.  The server is an echo service on
+ * 'shards' Executives, each run by its own thread with its own
+ * EXECUTIVE_LISTEN_REUSEPORT listener on the one port, and a 5s idle
+ * timeout on every connection.  The load generator is 'clients'
+ * threads, each repeatedly connecting, making 'requests' round trips
+ * of a small message, timing each, then closing (by RST, so as not to
+ * exhaust ports with TIME_WAITs).  Printed are connections and
+ * requests per second, and request latency percentiles (p50, p99,
+ * p99.9, max) in µs.
+ *
+ * Linux-specific, like bench-wakeup.c.
+ *
+ * Usage: bench-tcp [seconds] [shards] [clients] [requests]
+ */
+
+#define MESSAGE 16
+
+typedef struct Shard {
+  Executive* executive;
+  ExecutiveListener* listener;
+  int stop[2];
+  pthread_t thread;
+} Shard;
+
+typedef struct Client {
+  unsigned short port;
+  int requests;
+  struct timeval until;
+  size_t connections;
+  long* samples;
+  size_t samplesLength;
+  size_t samplesCapacity;
+  pthread_t thread;
+} Client;
+
+static void echoRead( ExecutiveConnection* c, const char* data, size_t length,
+					  void* env ) {
+  (void)env;
+  executiveConnectionWrite( c, data, length );
+}
+
+static void acceptEcho( ExecutiveListener* l, ExecutiveConnection* c,
+						struct timeval* now, void* env ) {
+  (void)l;
+  (void)now;
+  (void)env;
+  executiveConnectionSetActions( c, echoRead, NULL, NULL, NULL );
+}
+
+static void execActionStop( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  executiveStop( executiveEventExecutive( e ) );
+}
+
+static void* shardRun( void* arg ) {
+  Shard* s = arg;
+  executiveRun( s->executive );
+  return NULL;
+}
+
+static long elapsedUs( struct timespec* from, struct timespec* to ) {
+  return (to->tv_sec - from->tv_sec) * 1000000L +
+	(to->tv_nsec - from->tv_nsec) / 1000;
+}
+
+static void* clientRun( void* arg ) {
+  Client* c = arg;
+  struct sockaddr_in sin = { .sin_family = AF_INET,
+							 .sin_port = htons( c->port ) };
+  sin.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  char request[MESSAGE], reply[MESSAGE];
+  memset( request, 'x', sizeof( request ) );
+  struct linger rst = { 1, 0 };
+  int one = 1;
+
+  for( ;; ) {
+	struct timeval now;
+	gettimeofday( &now, NULL );
+	if( timercmp( &now, &c->until, > ) )
+	  break;
+	int fd = socket( AF_INET, SOCK_STREAM, 0 );
+	if( fd < 0 )
+	  break;
+	setsockopt( fd, SOL_SOCKET, SO_LINGER, &rst, sizeof( rst ) );
+	setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof( one ) );
+	if( connect( fd, (struct sockaddr*)&sin, sizeof( sin ) ) ) {
+	  close( fd );
+	  continue;
+	}
+	for( int r = 0; r < c->requests; r++ ) {
+	  struct timespec t0, t1;
+	  clock_gettime( CLOCK_MONOTONIC, &t0 );
+	  if( write( fd, request, sizeof( request ) ) != sizeof( request ) )
+		break;
+	  size_t got = 0;
+	  while( got < sizeof( reply ) ) {
+		ssize_t nin = read( fd, reply + got, sizeof( reply ) - got );
+		if( nin <= 0 )
+		  break;
+		got += nin;
+	  }
+	  if( got < sizeof( reply ) )
+		break;
+	  clock_gettime( CLOCK_MONOTONIC, &t1 );
+	  if( c->samplesLength < c->samplesCapacity )
+		c->samples[c->samplesLength++] = elapsedUs( &t0, &t1 );
+	}
+	close( fd );
+	c->connections++;
+  }
+  return NULL;
+}
+
+static int compareLong( const void* a, const void* b ) {
+  long la = *(const long*)a, lb = *(const long*)b;
+  return la < lb ? -1 : la > lb;
+}
+
+static long percentile( long* samples, size_t length, double p ) {
+  return samples[(size_t)(p * (length - 1))];
+}
+
+int main( int argc, char* argv[] ) {
+
+  int seconds = argc > 1 ? atoi( argv[1] ) : 2;
+  int shardsLength = argc > 2 ? atoi( argv[2] ) : 2;
+  int clientsLength = argc > 3 ? atoi( argv[3] ) : 8;
+  int requests = argc > 4 ? atoi( argv[4] ) : 4;
+  if( seconds < 1 || shardsLength < 1 || clientsLength < 1 || requests < 1 ) {
+	fprintf( stderr, "Usage: %s [seconds] [shards] [clients] [requests]\n",
+			 argv[0] );
+	return 1;
+  }
+  signal( SIGPIPE, SIG_IGN );
+
+  Shard* shards = calloc( shardsLength, sizeof( Shard ) );
+  Client* clients = calloc( clientsLength, sizeof( Client ) );
+  if( !shards || !clients )
+	return 1;
+
+  unsigned short port = 0;
+  struct timeval idle = { 5, 0 };
+  for( int i = 0; i < shardsLength; i++ ) {
+	Shard* s = &shards[i];
+	s->executive = executiveNew();
+	s->listener = executiveListenerNew( s->executive, "127.0.0.1", port,
+										EXECUTIVE_LISTEN_REUSEPORT,
+										acceptEcho, NULL );
+	if( !s->listener || pipe( s->stop ) ) {
+	  perror( "listen" );
+	  return 1;
+	}
+	port = executiveListenerPort( s->listener );
+	executiveListenerSetIdle( s->listener, &idle );
+	executiveWatchFd( s->executive, s->stop[0], execActionStop, NULL );
+	pthread_create( &s->thread, NULL, shardRun, s );
+  }
+
+  struct timeval until;
+  gettimeofday( &until, NULL );
+  until.tv_sec += seconds;
+  for( int i = 0; i < clientsLength; i++ ) {
+	Client* c = &clients[i];
+	c->port = port;
+	c->requests = requests;
+	c->until = until;
+	c->samplesCapacity = (size_t)seconds * 200000;
+	c->samples = malloc( c->samplesCapacity * sizeof( long ) );
+	if( !c->samples )
+	  return 1;
+	pthread_create( &c->thread, NULL, clientRun, c );
+  }
+
+  size_t connections = 0, samplesLength = 0;
+  for( int i = 0; i < clientsLength; i++ ) {
+	pthread_join( clients[i].thread, NULL );
+	connections += clients[i].connections;
+	samplesLength += clients[i].samplesLength;
+  }
+
+  printf( "%6s %7s %8s %10s %10s %8s %8s %8s %8s\n", "shards", "clients",
+		  "requests", "conns/s", "reqs/s", "p50", "p99", "p99.9", "max" );
+  long* samples = malloc( (samplesLength ? samplesLength : 1) *
+						  sizeof( long ) );
+  if( !samples )
+	return 1;
+  size_t n = 0;
+  for( int i = 0; i < clientsLength; i++ ) {
+	memcpy( samples + n, clients[i].samples,
+			clients[i].samplesLength * sizeof( long ) );
+	n += clients[i].samplesLength;
+	free( clients[i].samples );
+  }
+  qsort( samples, samplesLength, sizeof( long ), compareLong );
+  if( samplesLength )
+	printf( "%6d %7d %8d %10.0f %10.0f %8ld %8ld %8ld %8ld\n",
+			shardsLength, clientsLength, requests,
+			(double)connections / seconds, (double)samplesLength / seconds,
+			percentile( samples, samplesLength, 0.5 ),
+			percentile( samples, samplesLength, 0.99 ),
+			percentile( samples, samplesLength, 0.999 ),
+			samples[samplesLength - 1] );
+
+  for( int i = 0; i < shardsLength; i++ ) {
+	Shard* s = &shards[i];
+	ssize_t nout = write( s->stop[1], "x", 1 );
+	(void)nout;
+	pthread_join( s->thread, NULL );
+	executiveListenerFree( s->listener );
+	close( s->stop[0] );
+	close( s->stop[1] );
+  }
+  // any connections still open are abandoned with their Executives
+  for( int i = 0; i < shardsLength; i++ )
+	executiveFree( shards[i].executive );
+
+  free( samples );
+  free( clients );
+  free( shards );
+  return 0;
+}
+
+// eof
@@ -0,0 +1,347 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/select.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+
+#include "executive/executive.h"
+
+/**
+ * @author Stuart Maclean
+ *
+ * How late do Executive Events actually fire?  Many periodic Events
+ * are scheduled, and each records its lateness (actual less scheduled
+ * time) when fired.  The Executive is driven by a foobar-style main
+ * loop, once per way of waiting for the head Event's time:
+ *
+ * select, ppoll, epoll_pwait2 - relative timeout, µs/ns resolution
+ *
+ * timerfd - absolute timer on the head time, then poll with no timeout
+ *
+ * clock_nanosleep - absolute sleep, so no fd can be watched meanwhile
+ *
+ * each when idle, and then under synthetic I/O load: a child process
+ * writing small messages down a pipe, as fast as it can with a short
+ * pause between each, which the loop reads as it would user input.
+ * Lateness percentiles (p50, p99, p99.9, max) are printed in µs.
+ *
+ * Linux-specific, like foobar-timerfd.c.
+ *
+ * Usage: bench-wakeup [secondsPerRun]
+ */
+
+#define TIMERS 64
+
+typedef enum { SELECT, PPOLL, EPOLL, TIMERFD, NANOSLEEP, WAITS } Wait;
+
+static const char* waitNames[WAITS] = {
+  "select", "ppoll", "epoll_pwait2", "timerfd", "clock_nanosleep"
+};
+
+// Lateness samples, in µs
+static long* samples;
+static size_t samplesLength;
+static size_t samplesCapacity;
+
+static bool done;
+
+typedef struct Timer {
+  struct timeval period;
+} Timer;
+
+static void execActionTick( Event* e, struct timeval* actualTime ) {
+  struct timeval* scheduled = executiveEventScheduledTime( e );
+  struct timeval late;
+  timersub( actualTime, scheduled, &late );
+  if( samplesLength < samplesCapacity )
+	samples[samplesLength++] = late.tv_sec * 1000000L + late.tv_usec;
+
+  Timer* t = (Timer*)executiveEventEnv( e );
+  struct timeval next;
+  timeradd( scheduled, &t->period, &next );
+  executiveAddWithEnv( executiveEventExecutive( e ), &next, execActionTick, t );
+}
+
+static void execActionDone( Event* e, struct timeval* actualTime ) {
+  (void)e;
+  (void)actualTime;
+  done = true;
+}
+
+static int compareLong( const void* a, const void* b ) {
+  long la = *(const long*)a, lb = *(const long*)b;
+  return la < lb ? -1 : la > lb;
+}
+
+static long percentile( double p ) {
+  size_t i = (size_t)(p * (samplesLength - 1));
+  return samples[i];
+}
+
+/*
+  Wait for the head time, or input on fd (-1 for none). Returns as
+  per the underlying call: > 0 input ready, 0 timed out, -1 error.
+*/
+static int waitSelect( struct timeval* head, int fd ) {
+  struct timeval now, wait;
+  gettimeofday( &now, NULL );
+  if( timercmp( head, &now, < ) )
+	return 0;
+  timersub( head, &now, &wait );
+  fd_set fds;
+  FD_ZERO( &fds );
+  if( fd >= 0 )
+	FD_SET( fd, &fds );
+  return select( fd + 1, &fds, NULL, NULL, &wait );
+}
+
+static struct timespec untilHead( struct timeval* head ) {
+  struct timeval now, wait = { 0, 0 };
+  gettimeofday( &now, NULL );
+  if( timercmp( head, &now, > ) )
+	timersub( head, &now, &wait );
+  struct timespec result = { wait.tv_sec, wait.tv_usec * 1000 };
+  return result;
+}
+
+static int waitPpoll( struct timeval* head, int fd ) {
+  struct timespec wait = untilHead( head );
+  struct pollfd pfd = { .fd = fd, .events = POLLIN };
+  return ppoll( &pfd, fd >= 0 ? 1 : 0, &wait, NULL );
+}
+
+static int epollFd = -1;
+
+static int waitEpoll( struct timeval* head, int fd ) {
+#ifdef SYS_epoll_pwait2
+  struct timespec wait = untilHead( head );
+  struct epoll_event ev;
+  (void)fd;
+  return syscall( SYS_epoll_pwait2, epollFd, &ev, 1, &wait, NULL, 0 );
+#else
+  (void)head;
+  (void)fd;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+static int timerFd = -1;
+
+static int waitTimerfd( struct timeval* head, int fd ) {
+  struct itimerspec when = { { 0, 0 }, { head->tv_sec, head->tv_usec * 1000 } };
+  timerfd_settime( timerFd, TFD_TIMER_ABSTIME, &when, NULL );
+  struct pollfd pfds[2] = { { .fd = timerFd, .events = POLLIN },
+							{ .fd = fd, .events = POLLIN } };
+  int ready = poll( pfds, fd >= 0 ? 2 : 1, -1 );
+  if( ready < 1 )
+	return ready;
+  if( pfds[0].revents ) {
+	unsigned long long expirations;
+	ssize_t nin = read( timerFd, &expirations, sizeof( expirations ) );
+	(void)nin;
+  }
+  return fd >= 0 && pfds[1].revents ? 1 : 0;
+}
+
+// No fd can be watched while asleep, input is only seen between Events
+static int waitNanosleep( struct timeval* head, int fd ) {
+  struct timespec when = { head->tv_sec, head->tv_usec * 1000 };
+  int sc = clock_nanosleep( CLOCK_REALTIME, TIMER_ABSTIME, &when, NULL );
+  if( sc ) {
+	errno = sc;
+	return -1;
+  }
+  if( fd < 0 )
+	return 0;
+  struct pollfd pfd = { .fd = fd, .events = POLLIN };
+  return poll( &pfd, 1, 0 );
+}
+
+static int (*waits[WAITS])( struct timeval*, int ) = {
+  waitSelect, waitPpoll, waitEpoll, waitTimerfd, waitNanosleep
+};
+
+/*
+  The synthetic load: a child process writing 64 byte messages to the
+  pipe every 20µs or so, until killed.
+*/
+static pid_t loadStart( int* fdp ) {
+  int fds[2];
+  if( pipe( fds ) )
+	return -1;
+  pid_t pid = fork();
+  if( pid == 0 ) {
+	close( fds[0] );
+	char message[64];
+	memset( message, 'x', sizeof( message ) );
+	struct timespec pause = { 0, 20000 };
+	while( write( fds[1], message, sizeof( message ) ) > 0 )
+	  nanosleep( &pause, NULL );
+	_exit( 0 );
+  }
+  close( fds[1] );
+  *fdp = fds[0];
+  return pid;
+}
+
+static void loadStop( pid_t pid, int fd ) {
+  kill( pid, SIGTERM );
+  waitpid( pid, NULL, 0 );
+  close( fd );
+}
+
+static int run( Wait w, bool loaded, int seconds ) {
+  int fd = -1;
+  pid_t pid = 0;
+  if( loaded ) {
+	pid = loadStart( &fd );
+	if( pid < 0 )
+	  return -1;
+  }
+  if( w == EPOLL ) {
+	epollFd = epoll_create1( 0 );
+	if( fd >= 0 ) {
+	  struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+	  epoll_ctl( epollFd, EPOLL_CTL_ADD, fd, &ev );
+	}
+  }
+  if( w == TIMERFD )
+	timerFd = timerfd_create( CLOCK_REALTIME, 0 );
+
+  Executive* E = executiveNew();
+  struct timeval now;
+  gettimeofday( &now, NULL );
+
+  // periods of 1 to 8ms, first firings staggered across a period
+  Timer timers[TIMERS];
+  for( int i = 0; i < TIMERS; i++ ) {
+	timers[i].period.tv_sec = 0;
+	timers[i].period.tv_usec = 1000 * (1 + i % 8);
+	struct timeval offset = { 0, 1000 + 997 * i % timers[i].period.tv_usec };
+	struct timeval first;
+	timeradd( &now, &offset, &first );
+	executiveAddWithEnv( E, &first, execActionTick, &timers[i] );
+  }
+  struct timeval runTime = { seconds, 0 }, end;
+  timeradd( &now, &runTime, &end );
+  executiveAdd( E, &end, execActionDone );
+
+  samplesLength = 0;
+  done = false;
+  int result = 0;
+  while( !done ) {
+	gettimeofday( &now, NULL );
+	struct timeval* head = executivePeek( E );
+	if( !timercmp( head, &now, > ) ) {
+	  executiveFire( E, &now );
+	  continue;
+	}
+	int ready = waits[w]( head, fd );
+	if( ready == -1 ) {
+	  if( errno == EINTR )
+		continue;
+	  result = -1;
+	  break;
+	}
+	if( ready > 0 ) {
+	  char input[4096];
+	  ssize_t nin = read( fd, input, sizeof( input ) );
+	  (void)nin;
+	}
+  }
+
+  executiveFree( E );
+  if( epollFd >= 0 )
+	close( epollFd );
+  if( timerFd >= 0 )
+	close( timerFd );
+  epollFd = timerFd = -1;
+  if( loaded )
+	loadStop( pid, fd );
+  return result;
+}
+
+int main( int argc, char* argv[] ) {
+
+  int seconds = argc > 1 ? atoi( argv[1] ) : 2;
+  if( seconds < 1 )
+	seconds = 1;
+
+  // 64 timers, periods 1-8ms, so ~22k firings/sec, leave headroom
+  samplesCapacity = (size_t)seconds * 32000;
+  samples = malloc( samplesCapacity * sizeof( long ) );
+  if( !samples )
+	return 1;
+
+  printf( "%-16s %-5s %8s %8s %8s %8s %8s\n",
+		  "wait", "load", "samples", "p50", "p99", "p99.9", "max" );
+  for( int loaded = 0; loaded < 2; loaded++ ) {
+	for( Wait w = 0; w < WAITS; w++ ) {
+	  if( run( w, loaded, seconds ) ) {
+		printf( "%-16s %-5s %s\n", waitNames[w], loaded ? "io" : "idle",
+				strerror( errno ) );
+		continue;
+	  }
+	  qsort( samples, samplesLength, sizeof( long ), compareLong );
+	  if( samplesLength == 0 )
+		continue;
+	  printf( "%-16s %-5s %8zu %8ld %8ld %8ld %8ld\n",
+			  waitNames[w], loaded ? "io" : "idle", samplesLength,
+			  percentile( 0.5 ), percentile( 0.99 ), percentile( 0.999 ),
+			  samples[samplesLength - 1] );
+	}
+  }
+
+  free( samples );
+  return 0;
+}
+
+// eof
@@ -0,0 +1,154 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "executive/concurrent.h"
+
+/**
+ * The concurrent Executive, used by one thread, then stressed by
+ * many.
+ */
+
+static void execActionRecord( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  long* lp = executiveEventEnv( e );
+  *lp = executiveEventScheduledTime( e )->tv_sec;
+}
+
+/*
+  Events never fire before they are due, and all due Events fire.
+*/
+static void test1(void) {
+  ConcurrentExecutive* ce = executiveConcurrentNew( 1 );
+  long fired = 0;
+  for( int i = 0; i < 1000; i++ ) {
+	struct timeval tv = { 1 + rand() % 500, 0 };
+	int sc = executiveConcurrentAdd( ce, &tv, execActionRecord, &fired );
+	assert( sc == 0 );
+  }
+  assert( executiveConcurrentLength( ce ) == 1000 );
+
+  struct timeval head;
+  assert( executiveConcurrentPeek( ce, &head ) );
+  struct timeval now = { 250, 0 };
+  while( executiveConcurrentFire( ce, &now ) )
+	assert( fired <= 250 );
+  struct timeval next;
+  assert( executiveConcurrentPeek( ce, &next ) && next.tv_sec > 250 );
+
+  now.tv_sec = 1000;
+  while( executiveConcurrentFire( ce, &now ) )
+	;
+  assert( executiveConcurrentLength( ce ) == 0 );
+  assert( !executiveConcurrentPeek( ce, &next ) );
+
+  executiveConcurrentFree( ce );
+}
+
+#define THREADS 16
+#define PER_THREAD 20000
+
+typedef struct Stress {
+  ConcurrentExecutive* ce;
+  atomic_int* fired;
+  int base;
+} Stress;
+
+static void execActionOnce( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  atomic_int* ip = executiveEventEnv( e );
+  int was = atomic_fetch_add( ip, 1 );
+  assert( was == 0 );
+}
+
+// each thread adds its share, firing as it goes, then helps drain
+static void* stress( void* arg ) {
+  Stress* s = (Stress*)arg;
+  struct timeval now = { 1000, 0 };
+  for( int i = 0; i < PER_THREAD; i++ ) {
+	struct timeval tv = { rand() % 1000, 0 };
+	int sc = executiveConcurrentAdd( s->ce, &tv, execActionOnce,
+									 &s->fired[s->base + i] );
+	assert( sc == 0 );
+	if( i % 2 )
+	  executiveConcurrentFire( s->ce, &now );
+  }
+  while( executiveConcurrentFire( s->ce, &now ) )
+	;
+  return NULL;
+}
+
+/*
+  Many threads adding and firing at once: every Event fires exactly
+  once.
+*/
+static void test2(void) {
+  ConcurrentExecutive* ce = executiveConcurrentNew( THREADS );
+  atomic_int* fired = calloc( THREADS * PER_THREAD, sizeof( atomic_int ) );
+  assert( fired );
+
+  pthread_t threads[THREADS];
+  Stress stresses[THREADS];
+  for( int i = 0; i < THREADS; i++ ) {
+	stresses[i] = (Stress){ ce, fired, i * PER_THREAD };
+	int sc = pthread_create( &threads[i], NULL, stress, &stresses[i] );
+	assert( sc == 0 );
+  }
+  for( int i = 0; i < THREADS; i++ )
+	pthread_join( threads[i], NULL );
+
+  assert( executiveConcurrentLength( ce ) == 0 );
+  for( int i = 0; i < THREADS * PER_THREAD; i++ )
+	assert( atomic_load( &fired[i] ) == 1 );
+
+  free( fired );
+  executiveConcurrentFree( ce );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  return 0;
+}
+
+// eof
@@ -0,0 +1,218 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+
+#include "executive/debounce.h"
+#include "executive/loop.h"
+
+/**
+ * Debounce and throttle, driven by triggers every 10ms, on a virtual
+ * clock.
+ */
+
+typedef struct Calls {
+  long at[16];
+  int count;
+} Calls;
+
+static Calls calls;
+static bool throttling;
+static int key;
+
+static long msecs( struct timeval* tv ) {
+  return (tv->tv_sec - 1000) * 1000L + tv->tv_usec / 1000;
+}
+
+static void execActionCall( Event* e, struct timeval* actualTime ) {
+  Calls* c = executiveEventEnv( e );
+  c->at[c->count++] = msecs( actualTime );
+}
+
+static void execActionTrigger( Event* e, struct timeval* actualTime ) {
+  struct timeval period = { 0, 100000 };
+  Executive* E = executiveEventExecutive( e );
+  if( throttling )
+	executiveThrottle( E, &key, actualTime, &period, execActionCall, &calls );
+  else
+	executiveDebounce( E, &key, actualTime, &period, execActionCall, &calls );
+}
+
+// 50 triggers, at 0, 10, .. 490ms
+static void run( Executive* e ) {
+  calls.count = 0;
+  for( int i = 0; i < 50; i++ ) {
+	struct timeval tv = { 1000, i * 10000 };
+	executiveAdd( e, &tv, execActionTrigger );
+  }
+  struct timeval until = { 2000, 0 };
+  executiveRunSimulated( e, &until );
+  assert( executiveLength( e ) == 0 );
+}
+
+// Just the one call, 100ms after the last trigger
+static void test1(void) {
+  Executive* e = executiveNew();
+  throttling = false;
+  run( e );
+  assert( calls.count == 1 );
+  assert( calls.at[0] == 590 );
+  executiveFree( e );
+}
+
+// A call at once, then one per 100ms, the last for triggers 410-490
+static void test2(void) {
+  Executive* e = executiveNew();
+  throttling = true;
+  run( e );
+  assert( calls.count == 6 );
+  for( int i = 0; i < 6; i++ )
+	assert( calls.at[i] == i * 100 );
+  executiveFree( e );
+}
+
+// Many keys, some cancelled, the rest discarded with the Executive
+static void test3(void) {
+  Executive* e = executiveNew();
+  struct timeval now = { 1000, 0 };
+  struct timeval delay = { 1, 0 };
+  static char keys[100];
+  calls.count = 0;
+  for( int j = 0; j < 3; j++ )
+	for( int i = 0; i < 100; i++ )
+	  assert( executiveDebounce( e, keys + i, &now, &delay,
+								 execActionCall, &calls ) == 0 );
+  assert( executiveLength( e ) == 100 );
+
+  for( int i = 0; i < 100; i += 2 )
+	assert( executiveDebounceCancel( e, keys + i ) == 0 );
+  assert( executiveDebounceCancel( e, keys ) == -1 );
+  assert( executiveLength( e ) == 50 );
+
+  struct timeval until = { 1000, 999999 };
+  executiveRunSimulated( e, &until );
+  assert( calls.count == 0 );
+  executiveFree( e );
+}
+
+/*
+  Keys move with their Events, so outlive their first Executive.  A
+  key dst has already is left unlinked, but still makes its call.
+*/
+static void test4(void) {
+  Executive* a = executiveNew();
+  Executive* b = executiveNew();
+  struct timeval now = { 1000, 0 }, later = { 1000, 50000 };
+  struct timeval delay = { 0, 100000 };
+  static char keys[2];
+  calls.count = 0;
+  assert( executiveDebounce( a, keys, &now, &delay,
+							 execActionCall, &calls ) == 0 );
+  assert( executiveDebounce( a, keys + 1, &now, &delay,
+							 execActionCall, &calls ) == 0 );
+  assert( executiveDebounce( b, keys + 1, &now, &delay,
+							 execActionCall, &calls ) == 0 );
+  assert( executiveMerge( b, a ) == 2 );
+  executiveFree( a );
+
+  // keys[0] is b's now, so this trigger is coalesced
+  assert( executiveDebounce( b, keys, &later, &delay,
+							 execActionCall, &calls ) == 0 );
+  assert( executiveLength( b ) == 3 );
+  // b's own keys[1], not a's
+  assert( executiveDebounceCancel( b, keys + 1 ) == 0 );
+  assert( executiveDebounceCancel( b, keys + 1 ) == -1 );
+  assert( executiveLength( b ) == 2 );
+
+  struct timeval until = { 1001, 0 };
+  executiveRunSimulated( b, &until );
+  assert( calls.count == 2 );
+  assert( calls.at[0] == 100 );
+  assert( calls.at[1] == 150 );
+  assert( executiveLength( b ) == 0 );
+  executiveFree( b );
+}
+
+/*
+  With the Executive full, a debounced key that cannot wait on is
+  called at once, and a throttled key that cannot is forgotten.
+*/
+static void test5(void) {
+  Executive* e = executiveNew();
+  struct timeval now = { 1000, 0 }, later = { 1000, 50000 };
+  struct timeval delay = { 0, 100000 }, filler = { 2000, 0 };
+  static char keys[2];
+  calls.count = 0;
+  assert( executiveDebounce( e, keys, &now, &delay,
+							 execActionCall, &calls ) == 0 );
+  assert( executiveDebounce( e, keys, &later, &delay,
+							 execActionCall, &calls ) == 0 );
+  assert( executiveThrottle( e, keys + 1, &now, &delay,
+							 execActionCall, &calls ) == 0 );
+  executiveAdd( e, &filler, execActionCall );
+  executiveSetLimits( e, 1, 0 );
+
+  // the throttle call, then the debounce's, 50ms early
+  struct timeval until = { 1000, 120000 };
+  executiveRunSimulated( e, &until );
+  assert( calls.count == 2 );
+  assert( calls.at[0] == 0 );
+  assert( calls.at[1] == 100 );
+  assert( executiveLength( e ) == 1 );
+  assert( executiveDebounceCancel( e, keys ) == -1 );
+  assert( executiveDebounceCancel( e, keys + 1 ) == -1 );
+  executiveFree( e );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  if(4)
+	test4();
+
+  if(5)
+	test5();
+
+  return 0;
+}
+
+// eof
@@ -67,10 +67,284 @@ static void test1(void) {
   assert( i == 27+1 );
 }
 
+static void execActionRecord( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  int* ip = executiveEventEnv( e );
+  *ip = executiveEventScheduledTime( e )->tv_sec;
+}
+
+/*
+  Timeout queue Events interleave, by time, with ordinary Events. A
+  touched timeout moves to the tail of its queue.
+*/
+static void test2(void) {
+  Executive* e = executiveNew();
+
+  struct timeval idle = { 30, 0 };
+  struct timeval request = { 5, 0 };
+  ExecutiveTimeoutQueue* qIdle = executiveTimeoutQueue( e, &idle );
+  ExecutiveTimeoutQueue* qRequest = executiveTimeoutQueue( e, &request );
+  assert( executiveTimeoutQueue( e, &idle ) == qIdle );
+
+  int fired = 0;
+
+  struct timeval now = { 100, 0 };
+  Event* a = executiveTimeoutAdd( qIdle, &now, execActionRecord, &fired );
+  now.tv_sec = 101;
+  executiveTimeoutAdd( qIdle, &now, execActionRecord, &fired );
+  executiveTimeoutAdd( qRequest, &now, execActionRecord, &fired );
+  struct timeval tv = { 120, 0 };
+  executiveAddWithEnv( e, &tv, execActionRecord, &fired );
+  assert( executiveLength( e ) == 4 );
+  assert( executiveTimeoutQueueLength( qIdle ) == 2 );
+
+  // a now due at 102 + 30, behind its sibling at 101 + 30
+  now.tv_sec = 102;
+  executiveTimeoutTouch( a, &now );
+
+  int expected[] = { 106, 120, 131, 132 };
+  for( int i = 0; i < 4; i++ ) {
+	assert( executivePeek( e )->tv_sec == expected[i] );
+	executiveFire( e, &now );
+	assert( fired == expected[i] );
+  }
+  assert( executiveLength( e ) == 0 );
+
+  executiveFree( e );
+}
+
+/*
+  Child Executives: their Events are fired, in time order, via the
+  parent, and clearing or freeing a child removes all its Events from
+  the parent's view at once.
+*/
+static void test3(void) {
+  Executive* root = executiveNew();
+  Executive* a = executiveNew();
+  Executive* b = executiveNew();
+  Executive* aa = executiveNew();
+
+  int fired = 0;
+  struct timeval tv = { 40, 0 };
+  executiveAddWithEnv( root, &tv, execActionRecord, &fired );
+  tv.tv_sec = 10;
+  executiveAddWithEnv( a, &tv, execActionRecord, &fired );
+  tv.tv_sec = 30;
+  executiveAddWithEnv( b, &tv, execActionRecord, &fired );
+  tv.tv_sec = 50;
+  executiveAddWithEnv( b, &tv, execActionRecord, &fired );
+  tv.tv_sec = 20;
+  executiveAddWithEnv( aa, &tv, execActionRecord, &fired );
+
+  int sc = executiveAttachChild( root, a );
+  assert( sc == 0 );
+  sc = executiveAttachChild( root, b );
+  assert( sc == 0 );
+  sc = executiveAttachChild( a, aa );
+  assert( sc == 0 );
+  assert( executiveAttachChild( aa, root ) == -1 );
+  assert( executiveAttachChild( b, a ) == -1 );
+  assert( executiveParent( aa ) == a );
+  assert( executiveLength( root ) == 5 );
+  assert( executiveLength( a ) == 2 );
+
+  // changes in a grandchild reach the root
+  tv.tv_sec = 5;
+  executiveAddWithEnv( aa, &tv, execActionRecord, &fired );
+  assert( executivePeek( root )->tv_sec == 5 );
+
+  struct timeval now = { 100, 0 };
+  int expected[] = { 5, 10, 20, 30 };
+  for( int i = 0; i < 4; i++ ) {
+	executiveFire( root, &now );
+	assert( fired == expected[i] );
+  }
+  assert( executiveLength( root ) == 2 );
+
+  // b's pending Event at 50 vanishes in one go
+  executiveFree( b );
+  assert( executiveLength( root ) == 1 );
+  assert( executivePeek( root )->tv_sec == 40 );
+
+  sc = executiveDetachChild( root, a );
+  assert( sc == 0 );
+  assert( executiveDetachChild( root, a ) == -1 );
+  assert( executiveParent( a ) == NULL );
+
+  executiveFree( root );
+  executiveFree( aa );
+  executiveFree( a );
+}
+
+/*
+  A batch, unsorted, merged in among Events already pending.
+*/
+static void test4(void) {
+  Executive* e = executiveNew();
+
+  int fired = 0;
+  struct timeval tv = { 15, 0 };
+  executiveAddWithEnv( e, &tv, execActionRecord, &fired );
+  tv.tv_sec = 35;
+  executiveAddWithEnv( e, &tv, execActionRecord, &fired );
+
+  EventSpec specs[5];
+  int times[] = { 40, 10, 30, 20, 5 };
+  for( int i = 0; i < 5; i++ ) {
+	specs[i].scheduledTime.tv_sec = times[i];
+	specs[i].scheduledTime.tv_usec = 0;
+	specs[i].action = execActionRecord;
+	specs[i].env = &fired;
+  }
+  assert( executiveAddBatch( e, specs, 5 ) == 7 );
+
+  struct timeval now = { 100, 0 };
+  int expected[] = { 5, 10, 15, 20, 30, 35, 40 };
+  for( int i = 0; i < 7; i++ ) {
+	executiveFire( e, &now );
+	assert( fired == expected[i] );
+  }
+
+  // discarded, not fired, the block free'd with its last Event
+  assert( executiveAddBatch( e, specs, 5 ) == 5 );
+  executiveFire( e, &now );
+  executiveFree( e );
+}
+
+static int envFrees = 0;
+
+static void envFreeCounter( void* env ) {
+  (void)env;
+  envFrees++;
+}
+
+static bool isEnv( Event* e, void* env ) {
+  return executiveEventEnv( e ) == env;
+}
+
+static Executive* owner = NULL;
+
+static void execActionRecordOwner( Event* e, struct timeval* actualTime ) {
+  execActionRecord( e, actualTime );
+  assert( executiveEventExecutive( e ) == owner );
+}
+
+/*
+  Events moved, not copied, between Executives: no envFree calls, and
+  the moved Events interleave, by time, with those already in dst.
+*/
+static void test5(void) {
+  Executive* src = executiveNew();
+  Executive* dst = executiveNew();
+
+  int a = 0, b = 0;
+  int aTimes[] = { 10, 30, 50 }, bTimes[] = { 20, 40 }, dstTimes[] = { 15, 35 };
+  for( int i = 0; i < 3; i++ ) {
+	struct timeval tv = { aTimes[i], 0 };
+	executiveAddWithFreeFunc( src, &tv, execActionRecordOwner, &a,
+							  envFreeCounter );
+  }
+  for( int i = 0; i < 2; i++ ) {
+	struct timeval tv = { bTimes[i], 0 };
+	executiveAddWithEnv( src, &tv, execActionRecordOwner, &b );
+	tv.tv_sec = dstTimes[i];
+	executiveAddWithEnv( dst, &tv, execActionRecordOwner, &a );
+  }
+  struct timeval now = { 0, 0 };
+  struct timeval duration = { 100, 0 };
+  ExecutiveTimeoutQueue* q = executiveTimeoutQueue( src, &duration );
+  Event* timeout = executiveTimeoutAdd( q, &now, execActionRecordOwner, &a );
+
+  size_t bytes = executiveBytes( src ) + executiveBytes( dst );
+  assert( executiveMigrate( src, dst, isEnv, &a ) == 4 );
+  assert( envFrees == 0 );
+  assert( executiveLength( src ) == 2 );
+  assert( executiveLength( dst ) == 6 );
+  assert( executiveEventExecutive( timeout ) == dst );
+  assert( executiveTimeoutQueueLength( q ) == 0 );
+  assert( executiveBytes( src ) + executiveBytes( dst ) == bytes );
+
+  owner = dst;
+  now.tv_sec = 1000;
+  int expected[] = { 10, 15, 30, 35, 50, 100 };
+  for( int i = 0; i < 6; i++ ) {
+	executiveFire( dst, &now );
+	assert( a == expected[i] );
+  }
+  assert( envFrees == 3 );
+  assert( executiveLength( dst ) == 0 );
+
+  assert( executiveMerge( dst, src ) == 2 );
+  assert( executiveLength( src ) == 0 );
+  assert( executiveBytes( src ) == 0 );
+  executiveFire( dst, &now );
+  assert( b == 20 );
+  executiveFree( src );
+  executiveFree( dst );
+}
+
+/*
+  Adds interleaved with peeks and fires, some before the head time, as
+  the radix heap store (make RADIX=1) then holds apart.  Whatever the
+  store, Events must fire in time order.
+*/
+static void test6(void) {
+  Executive* e = executiveNew();
+
+  int fired = 0;
+  int times[] = { 1000, 40, 700, 65, 3, 64, 900, 12, 66, 2 };
+  for( int i = 0; i < 10; i++ ) {
+	struct timeval tv = { times[i], 0 };
+	executiveAddWithEnv( e, &tv, execActionRecord, &fired );
+	if( i % 3 == 2 )
+	  (void)executivePeek( e );
+  }
+  assert( executivePeek( e )->tv_sec == 2 );
+
+  struct timeval tv = { 64, 0 };
+  assert( executiveClearMatchingTime( e, &tv ) == 1 );
+
+  struct timeval now = { 10000, 0 };
+  int expected[] = { 2, 3, 12, 40 };
+  for( int i = 0; i < 4; i++ ) {
+	executiveFire( e, &now );
+	assert( fired == expected[i] );
+  }
+
+  // now some earlier than the last fired
+  int later[] = { 50, 20, 800, 1 };
+  for( int i = 0; i < 4; i++ ) {
+	tv.tv_sec = later[i];
+	executiveAddWithEnv( e, &tv, execActionRecord, &fired );
+  }
+  int rest[] = { 1, 20, 50, 65, 66, 700, 800, 900, 1000 };
+  for( int i = 0; i < 9; i++ ) {
+	executiveFire( e, &now );
+	assert( fired == rest[i] );
+  }
+  assert( executiveLength( e ) == 0 );
+  executiveFree( e );
+}
+
 int main(void) {
 
   if(1)
 	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  if(4)
+	test4();
+
+  if(5)
+	test5();
+
+  if(6)
+	test6();
   
   return 0;
 }
@@ -32,6 +32,7 @@
  * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
  * DAMAGE.
  */
+#include <errno.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -153,7 +154,9 @@ int main(void) {
 	fd_set work = fds;
     int ready = select( fdMax + 1, &work, NULL, NULL, &wait );
     if( ready == -1 ) {
-	  // ?? check for EINTR ??
+	  // a signal interrupted the wait, not an error, go round again
+	  if( errno == EINTR )
+		continue;
       break; 
     }
 	
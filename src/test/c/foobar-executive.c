@@ -32,6 +32,7 @@
  * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
  * DAMAGE.
  */
+#include <errno.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -163,7 +164,9 @@ int main(void) {
 	fd_set work = fds;
     int ready = select( fdMax + 1, &work, NULL, NULL, &wait );
     if( ready == -1 ) {
-	  // ?? check for EINTR, maybe continue ??
+	  // a signal interrupted the wait, not an error, go round again
+	  if( errno == EINTR )
+		continue;
       break; 
     }
 	
@@ -32,6 +32,7 @@
  * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
  * DAMAGE.
  */
+#include <errno.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
@@ -89,7 +90,9 @@ int main(void ) {
 	fd_set work = fds;
 	int ready = select( fdMax + 1, &work, NULL, NULL, NULL );
     if( ready == -1 ) {
-	  // ?? check for EINTR, maybe continue ??
+	  // a signal interrupted the wait, not an error, go round again
+	  if( errno == EINTR )
+		continue;
       break; 
     }
 
@@ -0,0 +1,176 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "executive/input.h"
+#include "executive/loop.h"
+
+/**
+ * Framed input over a pipe. Small maxRecord values, so that records
+ * wrap round the ring buffer.
+ */
+
+typedef struct Records {
+  char text[256];
+  int count;
+  bool ended;
+  int error;
+} Records;
+
+// Append each record, plus a '|', to the text seen so far
+static void inputActionCollect( ExecutiveInput* in,
+								const char* record, size_t length,
+								void* env ) {
+  Records* r = env;
+  if( !record ) {
+	r->ended = true;
+	r->error = errno;
+	executiveInputFree( in );
+	return;
+  }
+  strncat( r->text, record, length );
+  strcat( r->text, "|" );
+  r->count++;
+}
+
+static void put( int fd, const void* data, size_t length ) {
+  ssize_t nout = write( fd, data, length );
+  assert( nout == (ssize_t)length );
+}
+
+// Delimited records, several per read and split across reads
+static void test1(void) {
+  Executive* e = executiveNew();
+  int fds[2];
+  int sc = pipe( fds );
+  assert( sc == 0 );
+
+  Records r = { "", 0, false, 0 };
+  ExecutiveInput* in = executiveInputDelimited( e, fds[0], '\n', 8,
+												inputActionCollect, &r );
+  assert( in );
+
+  const char* chunks[] = { "ab\ncd\nef", "gh\n", "12345678\nx", "y\nz" };
+  for( int i = 0; i < 4; i++ ) {
+	put( fds[1], chunks[i], strlen( chunks[i] ) );
+	executiveRunOnce( e );
+  }
+  assert( strcmp( r.text, "ab|cd|efgh|12345678|xy|" ) == 0 );
+
+  // eof delivers the undelimited tail, then ends
+  close( fds[1] );
+  executiveRunOnce( e );
+  assert( strcmp( r.text, "ab|cd|efgh|12345678|xy|z|" ) == 0 );
+  assert( r.ended && r.error == 0 );
+
+  close( fds[0] );
+  executiveFree( e );
+}
+
+// Length-prefixed records, 2 byte prefix
+static void test2(void) {
+  Executive* e = executiveNew();
+  int fds[2];
+  int sc = pipe( fds );
+  assert( sc == 0 );
+
+  Records r = { "", 0, false, 0 };
+  ExecutiveInput* in = executiveInputPrefixed( e, fds[0], 2, 6,
+											   inputActionCollect, &r );
+  assert( in );
+
+  for( int i = 0; i < 10; i++ ) {
+	put( fds[1], "\0\5hello\0\0\0\3abc", 14 );
+	executiveRunOnce( e );
+  }
+  assert( r.count == 30 );
+  assert( strncmp( r.text, "hello||abc|hello||abc|", 22 ) == 0 );
+
+  // too long
+  put( fds[1], "\0\7", 2 );
+  executiveRunOnce( e );
+  assert( r.ended && r.error == EMSGSIZE );
+
+  close( fds[0] );
+  close( fds[1] );
+  executiveFree( e );
+}
+
+/*
+  A delimited record too long, though complete in one read and
+  wrapping round the ring, ends the input undelivered.
+*/
+static void test3(void) {
+  Executive* e = executiveNew();
+  int fds[2];
+  int sc = pipe( fds );
+  assert( sc == 0 );
+
+  Records r = { "", 0, false, 0 };
+  ExecutiveInput* in = executiveInputDelimited( e, fds[0], '\n', 8,
+												inputActionCollect, &r );
+  assert( in );
+
+  put( fds[1], "abcdef\n", 7 );
+  executiveRunOnce( e );
+  put( fds[1], "aaaaaaaaaaaaaa\nxy\n", 18 );
+  executiveRunOnce( e );
+  assert( strcmp( r.text, "abcdef|" ) == 0 );
+  assert( r.ended && r.error == EMSGSIZE );
+
+  close( fds[0] );
+  close( fds[1] );
+  executiveFree( e );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  return 0;
+}
+
+// eof
@@ -0,0 +1,260 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "executive/loop.h"
+#include "executive/parallel.h"
+
+/**
+ * Drive the run loop with a pipe and some timed Events.
+ */
+
+static void execActionRead( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  int* fds = executiveEventEnv( e );
+  char c;
+  int nin = read( fds[0], &c, 1 );
+  assert( nin == 1 );
+  fds[2] = c;
+}
+
+static void execActionWrite( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  int* fds = executiveEventEnv( e );
+  int nout = write( fds[1], "x", 1 );
+  assert( nout == 1 );
+}
+
+static void execActionStop( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  executiveStop( executiveEventExecutive( e ) );
+}
+
+/*
+  A timed Event writes to a pipe, the loop sees the read end ready and
+  calls its Action.  A later Event stops the loop.
+*/
+static void test1(void) {
+  Executive* e = executiveNew();
+
+  int fds[3] = { -1, -1, 0 };
+  int sc = pipe( fds );
+  assert( sc == 0 );
+  sc = executiveWatchFd( e, fds[0], execActionRead, fds );
+  assert( sc == 0 );
+
+  struct timeval now, tv;
+  gettimeofday( &now, NULL );
+  struct timeval delta = { 0, 10000 };
+  timeradd( &now, &delta, &tv );
+  executiveAddWithEnv( e, &tv, execActionWrite, fds );
+  timeradd( &tv, &delta, &tv );
+  executiveAdd( e, &tv, execActionStop );
+
+  sc = executiveRun( e );
+  assert( sc == 0 );
+  assert( fds[2] == 'x' );
+  assert( executiveLength( e ) == 0 );
+
+  // nothing timed, nothing watched: nothing to do
+  sc = executiveUnwatchFd( e, fds[0] );
+  assert( sc == 0 );
+  assert( executiveUnwatchFd( e, fds[0] ) == -1 );
+  assert( executiveRunOnce( e ) == 0 );
+
+  close( fds[0] );
+  close( fds[1] );
+  executiveFree( e );
+}
+
+/*
+  As test1, but spinning rather than blocking for the final stretch to
+  each Event, fd readiness still being seen meanwhile.
+*/
+static void test3(void) {
+  Executive* e = executiveNew();
+
+  struct timeval spin = { 0, 5000 };
+  int sc = executiveSetSpin( e, &spin );
+  assert( sc == 0 );
+
+  int fds[3] = { -1, -1, 0 };
+  sc = pipe( fds );
+  assert( sc == 0 );
+  sc = executiveWatchFd( e, fds[0], execActionRead, fds );
+  assert( sc == 0 );
+
+  struct timeval now, tv;
+  gettimeofday( &now, NULL );
+  struct timeval delta = { 0, 10000 };
+  timeradd( &now, &delta, &tv );
+  executiveAddWithEnv( e, &tv, execActionWrite, fds );
+  timeradd( &tv, &delta, &tv );
+  executiveAdd( e, &tv, execActionStop );
+
+  sc = executiveRun( e );
+  assert( sc == 0 );
+  assert( fds[2] == 'x' );
+
+  gettimeofday( &now, NULL );
+  assert( !timercmp( &now, &tv, < ) );
+
+  close( fds[0] );
+  close( fds[1] );
+  executiveFree( e );
+}
+
+/*
+  A periodic Action, re-adding itself 'actualTime + 1 hour' later, is
+  fired a day's worth of times, in no real time at all.
+*/
+static void execActionHourly( Event* e, struct timeval* actualTime ) {
+  int* ip = executiveEventEnv( e );
+  (*ip)++;
+  struct timeval hour = { 3600, 0 }, next;
+  timeradd( actualTime, &hour, &next );
+  executiveAddWithEnv( executiveEventExecutive( e ), &next,
+					   execActionHourly, ip );
+}
+
+static void test4(void) {
+  Executive* e = executiveNew();
+
+  int fired = 0;
+  struct timeval start = { 1000000, 0 };
+  executiveAddWithEnv( e, &start, execActionHourly, &fired );
+
+  struct timeval until = { 1000000 + 24 * 3600, 0 };
+  struct timeval before, after;
+  gettimeofday( &before, NULL );
+  size_t n = executiveRunSimulated( e, &until );
+  gettimeofday( &after, NULL );
+  assert( n == 25 && fired == 25 );
+  assert( executivePeek( e )->tv_sec == until.tv_sec + 3600 );
+  assert( after.tv_sec - before.tv_sec < 2 );
+
+  executiveFree( e );
+}
+
+#ifdef __linux__
+
+static void execActionCount( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  int* ip = executiveEventEnv( e );
+  (*ip)++;
+}
+
+/*
+  Signals are delivered as Actions, several arrivals coalescing into
+  one call per signal per wakeup.
+*/
+static void test2(void) {
+  Executive* e = executiveNew();
+
+  int usr1 = 0, usr2 = 0;
+  int sc = executiveWatchSignal( e, SIGUSR1, execActionCount, &usr1 );
+  assert( sc == 0 );
+  sc = executiveWatchSignal( e, SIGUSR2, execActionCount, &usr2 );
+  assert( sc == 0 );
+
+  raise( SIGUSR1 );
+  raise( SIGUSR2 );
+  raise( SIGUSR1 );
+  sc = executiveRunOnce( e );
+  assert( sc == 1 );
+  assert( usr1 == 1 && usr2 == 1 );
+
+  sc = executiveUnwatchSignal( e, SIGUSR2 );
+  assert( sc == 0 );
+  sigset_t mask;
+  sigprocmask( SIG_BLOCK, NULL, &mask );
+  assert( sigismember( &mask, SIGUSR1 ) && !sigismember( &mask, SIGUSR2 ) );
+
+  executiveFree( e );
+  sigprocmask( SIG_BLOCK, NULL, &mask );
+  assert( !sigismember( &mask, SIGUSR1 ) );
+}
+
+/*
+  The library's own threads, though created before the watch, do not
+  take the signal, sent to the process, from the loop.
+*/
+static void test5(void) {
+  Executive* e = executiveNew();
+  ExecutiveWorkers* w = executiveWorkersNew( 4, NULL );
+  assert( w );
+
+  int usr1 = 0;
+  int sc = executiveWatchSignal( e, SIGUSR1, execActionCount, &usr1 );
+  assert( sc == 0 );
+  for( int i = 0; i < 3; i++ )
+	kill( getpid(), SIGUSR1 );
+  sc = executiveRunOnce( e );
+  assert( sc == 1 );
+  assert( usr1 == 1 );
+
+  executiveWorkersFree( w );
+  executiveFree( e );
+}
+
+#endif
+
+int main(void) {
+
+  if(1)
+	test1();
+
+#ifdef __linux__
+  if(2)
+	test2();
+#endif
+
+  if(3)
+	test3();
+
+  if(4)
+	test4();
+
+#ifdef __linux__
+  if(5)
+	test5();
+#endif
+
+  return 0;
+}
+
+// eof
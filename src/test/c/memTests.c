@@ -33,6 +33,7 @@
  * DAMAGE.
  */
 #include <assert.h>
+#include <stddef.h>
 #include <stdlib.h>
 
 #include "executive/executive.h"
@@ -86,6 +87,111 @@ static void test3(void) {
   executiveFree( e );
 }
 
+/*
+  Timeout queues and any Events pending on them are released along
+  with their Executive.
+*/
+static void test4(void) {
+  Executive* e = executiveNew();
+
+  struct timeval idle = { 30, 0 };
+  ExecutiveTimeoutQueue* q = executiveTimeoutQueue( e, &idle );
+
+  struct timeval now = { 10, 0 };
+  Event* ev = executiveTimeoutAdd( q, &now, someExecAction, NULL );
+  executiveTimeoutAdd( q, &now, someExecAction, NULL );
+  executiveTimeoutCancel( ev );
+  assert( executiveLength( e ) == 1 );
+
+  executiveFree( e );
+}
+
+/*
+  A static Executive, in storage of our own, rejects Events beyond its
+  capacity, and recycles the slots of those fired/cancelled.
+*/
+static void test5(void) {
+  static max_align_t storage[256];
+  assert( executiveStaticSize( 4 ) <= sizeof( storage ) );
+  Executive* e = executiveInitStatic( storage, 4 );
+
+  struct timeval tv = { 10, 0 };
+  for( size_t i = 1; i <= 4; i++ )
+	assert( executiveAdd( e, &tv, someExecAction ) == i );
+  assert( executiveAdd( e, &tv, someExecAction ) == EXECUTIVE_FULL );
+  assert( executiveLength( e ) == 4 );
+
+  executiveFire( e, &tv );
+  assert( executiveAdd( e, &tv, someExecAction ) == 4 );
+
+  // the queue takes a slot, so room for no more Events
+  assert( executiveClear( e ) == 4 );
+  struct timeval idle = { 30, 0 };
+  ExecutiveTimeoutQueue* q = executiveTimeoutQueue( e, &idle );
+  for( size_t i = 1; i <= 3; i++ )
+	assert( executiveTimeoutAdd( q, &tv, someExecAction, NULL ) );
+  assert( !executiveTimeoutAdd( q, &tv, someExecAction, NULL ) );
+
+  // a batch needs all its slots, or gets none
+  EventSpec specs[2] = { { tv, someExecAction, NULL },
+						 { tv, someExecAction, NULL } };
+  assert( executiveAddBatch( e, specs, 2 ) == EXECUTIVE_FULL );
+  executiveClear( e );
+  assert( executiveAddBatch( e, specs, 2 ) == 2 );
+
+  executiveFree( e );
+}
+
+static void watermark( Executive* e, bool above, void* arg ) {
+  (void)e;
+  int* ip = (int*)arg;
+  *ip = above ? 1 : -1;
+}
+
+/*
+  Limits on count and bytes reject adds cleanly, and the watermark
+  callback sees the pending count cross high, then low.
+*/
+static void test6(void) {
+  Executive* e = executiveNew();
+  executiveSetLimits( e, 3, 0 );
+  int crossed = 0;
+  executiveSetWatermarks( e, 2, 1, watermark, &crossed );
+
+  struct timeval tv = { 10, 0 };
+  assert( executiveAdd( e, &tv, someExecAction ) == 1 );
+  assert( executiveAdd( e, &tv, someExecAction ) == 2 );
+  assert( crossed == 0 );
+  assert( executiveAdd( e, &tv, someExecAction ) == 3 );
+  assert( crossed == 1 );
+  assert( executiveAdd( e, &tv, someExecAction ) == EXECUTIVE_FULL );
+  assert( executiveLength( e ) == 3 );
+
+  executiveFire( e, &tv );
+  assert( crossed == 1 );
+  executiveFire( e, &tv );
+  assert( crossed == -1 );
+
+  // now by bytes, the env size counting too
+  executiveClear( e );
+  assert( executiveBytes( e ) == 0 );
+  executiveSetLimits( e, 0, 1000 );
+  assert( executiveAdd( e, &tv, someExecAction ) == 1 );
+  size_t perEvent = executiveBytes( e );
+  assert( perEvent > 0 );
+  struct timeval later = { 20, 0 };
+  assert( executiveAddWithEnvSize( e, &later, someExecAction, NULL,
+								   1000 - perEvent, NULL ) ==
+		  EXECUTIVE_FULL );
+  assert( executiveAddWithEnvSize( e, &later, someExecAction, NULL,
+								   1000 - 2 * perEvent, NULL ) == 2 );
+  assert( executiveBytes( e ) == 1000 );
+  executiveFire( e, &tv );
+  assert( executiveBytes( e ) == 1000 - perEvent );
+
+  executiveFree( e );
+}
+
 int main(void) {
 
   if(1)
@@ -96,6 +202,15 @@ int main(void) {
 
   if(3)
 	test3();
+
+  if(4)
+	test4();
+
+  if(5)
+	test5();
+
+  if(6)
+	test6();
   
   return 0;
 }
@@ -0,0 +1,161 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "executive/loop.h"
+#include "executive/output.h"
+
+/**
+ * Queued output over a pipe, flushed by the run loop.
+ */
+
+static int releases = 0;
+
+static void releaseCounter( void* arg ) {
+  (void)arg;
+  releases++;
+}
+
+// Copies and references, in order, in one writev
+static void test1(void) {
+  Executive* e = executiveNew();
+  int fds[2];
+  int sc = pipe( fds );
+  assert( sc == 0 );
+  fcntl( fds[1], F_SETFL, O_NONBLOCK );
+
+  ExecutiveOutput* out = executiveOutputNew( e, fds[1] );
+  assert( out );
+  static const char world[] = "world";
+  assert( executiveOutputWrite( out, "hello", 5 ) == 0 );
+  assert( executiveOutputWrite( out, ", ", 2 ) == 0 );
+  assert( executiveOutputWriteRef( out, world, 5, releaseCounter, NULL ) == 0 );
+  assert( executiveOutputWrite( out, "!", 1 ) == 0 );
+  assert( executiveOutputPending( out ) == 13 );
+  assert( releases == 0 );
+
+  // nothing else to do, but the flush happens first
+  executiveRunOnce( e );
+  assert( executiveOutputPending( out ) == 0 );
+  assert( releases == 1 );
+
+  char buf[32];
+  ssize_t nin = read( fds[0], buf, sizeof( buf ) );
+  assert( nin == 13 );
+  assert( memcmp( buf, "hello, world!", 13 ) == 0 );
+
+  // a reader gone, the error sticks, and references are still released
+  close( fds[0] );
+  signal( SIGPIPE, SIG_IGN );
+  executiveOutputWrite( out, "x", 1 );
+  assert( executiveOutputFlush( out ) == -1 );
+  assert( executiveOutputWriteRef( out, world, 5, releaseCounter, NULL ) == -1 );
+  assert( releases == 2 );
+
+  executiveOutputFree( out );
+  close( fds[1] );
+  executiveFree( e );
+}
+
+typedef struct Sink {
+  int fd;
+  size_t total;
+  size_t expected;
+} Sink;
+
+static void sinkReadable( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  Sink* s = executiveEventEnv( e );
+  char buf[8192];
+  ssize_t nin = read( s->fd, buf, sizeof( buf ) );
+  assert( nin > 0 );
+  for( ssize_t i = 0; i < nin; i++ )
+	assert( buf[i] == (char)((s->total + i) % 251) );
+  s->total += nin;
+  if( s->total == s->expected )
+	executiveStop( executiveEventExecutive( e ) );
+}
+
+/*
+  Far more than the pipe holds, so the writer backs up, and waits for
+  writability, while the reader drains it.
+*/
+static void test2(void) {
+  Executive* e = executiveNew();
+  int fds[2];
+  int sc = pipe( fds );
+  assert( sc == 0 );
+  fcntl( fds[1], F_SETFL, O_NONBLOCK );
+
+  ExecutiveOutput* out = executiveOutputNew( e, fds[1] );
+  char record[1000];
+  size_t n = 0;
+  for( int i = 0; i < 1024; i++ ) {
+	for( size_t j = 0; j < sizeof( record ); j++ )
+	  record[j] = (char)((n + j) % 251);
+	assert( executiveOutputWrite( out, record, sizeof( record ) ) == 0 );
+	n += sizeof( record );
+  }
+
+  Sink s = { fds[0], 0, n };
+  executiveWatchFd( e, fds[0], sinkReadable, &s );
+  assert( executiveOutputFlush( out ) > 0 );
+  assert( executiveRun( e ) == 0 );
+  assert( s.total == n );
+  assert( executiveOutputPending( out ) == 0 );
+
+  executiveOutputFree( out );
+  close( fds[0] );
+  close( fds[1] );
+  executiveFree( e );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  return 0;
+}
+
+// eof
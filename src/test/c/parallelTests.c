@@ -0,0 +1,228 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "executive/loop.h"
+#include "executive/parallel.h"
+
+/**
+ * Fire batches of due Events on worker threads.
+ */
+
+typedef struct Key {
+  pthread_t thread;
+  bool seen;
+  long last;
+  int count;
+} Key;
+
+/*
+  Events of one key run on one thread, in scheduled order. The early
+  ones each add a further Event, from the worker thread.
+*/
+static void execActionKeyed( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  Key* k = executiveEventEnv( e );
+  long t = executiveEventScheduledTime( e )->tv_sec;
+  if( k->seen ) {
+	assert( pthread_equal( k->thread, pthread_self() ) );
+	assert( t > k->last );
+  }
+  k->thread = pthread_self();
+  k->seen = true;
+  k->last = t;
+  k->count++;
+  if( t <= 100 ) {
+	struct timeval later = { t + 10000, 0 };
+	executiveAddWithEnv( executiveEventExecutive( e ), &later,
+						 execActionKeyed, k );
+  }
+}
+
+static void test1(void) {
+  Executive* e = executiveNew();
+  ExecutiveWorkers* w = executiveWorkersNew( 4, NULL );
+  assert( w );
+
+  Key keys[16] = { 0 };
+  for( int i = 1; i <= 1000; i++ ) {
+	struct timeval tv = { i, 0 };
+	executiveAddWithEnv( e, &tv, execActionKeyed, &keys[rand() % 16] );
+  }
+
+  struct timeval now = { 2000, 0 };
+  size_t n = executiveFireParallel( e, &now, w );
+  assert( n == 1000 );
+  int total = 0;
+  for( int i = 0; i < 16; i++ )
+	total += keys[i].count;
+  assert( total == 1000 );
+  assert( executiveLength( e ) == 100 );
+
+  // nothing due
+  assert( executiveFireParallel( e, &now, w ) == 0 );
+
+  executiveWorkersFree( w );
+  executiveFree( e );
+}
+
+static void execActionStop( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  executiveStop( executiveEventExecutive( e ) );
+}
+
+/*
+  The run loop opted in, due Events are fired via the workers.
+*/
+static void test2(void) {
+  Executive* e = executiveNew();
+  ExecutiveWorkers* w = executiveWorkersNew( 2, NULL );
+  assert( w );
+  int sc = executiveSetWorkers( e, w );
+  assert( sc == 0 );
+
+  Key keys[4] = { 0 };
+  for( int i = 101; i <= 200; i++ ) {
+	struct timeval tv = { i, 0 };
+	executiveAddWithEnv( e, &tv, execActionKeyed, &keys[i % 4] );
+  }
+  struct timeval tv = { 300, 0 };
+  executiveAdd( e, &tv, execActionStop );
+
+  sc = executiveRun( e );
+  assert( sc == 0 );
+  for( int i = 0; i < 4; i++ )
+	assert( keys[i].count == 25 );
+
+  executiveFree( e );
+  executiveWorkersFree( w );
+}
+
+static const size_t durations = 8;
+
+// From the workers, all at once, queues found or created, and used
+static void execActionTimeout( Event* e, struct timeval* actualTime ) {
+  size_t i = (size_t)executiveEventScheduledTime( e )->tv_sec;
+  struct timeval duration = { (time_t)(i % durations) + 1, 0 };
+  ExecutiveTimeoutQueue* q =
+	executiveTimeoutQueue( executiveEventExecutive( e ), &duration );
+  assert( q );
+  assert( executiveTimeoutAdd( q, actualTime, NULL, NULL ) );
+}
+
+static void test3(void) {
+  Executive* e = executiveNew();
+  ExecutiveWorkers* w = executiveWorkersNew( 4, NULL );
+  assert( w );
+
+  static int envs[256];
+  for( int i = 0; i < 256; i++ ) {
+	struct timeval tv = { i, 0 };
+	executiveAddWithEnv( e, &tv, execActionTimeout, &envs[i] );
+  }
+  struct timeval now = { 1000, 0 };
+  assert( executiveFireParallel( e, &now, w ) == 256 );
+  assert( executiveLength( e ) == 256 );
+  for( size_t i = 0; i < durations; i++ ) {
+	struct timeval duration = { (time_t)i + 1, 0 };
+	ExecutiveTimeoutQueue* q = executiveTimeoutQueue( e, &duration );
+	assert( executiveTimeoutQueueLength( q ) == 256 / durations );
+  }
+
+  executiveWorkersFree( w );
+  executiveFree( e );
+}
+
+static Executive* child;
+
+static bool onQueue( Event* e, void* ctx ) {
+  (void)ctx;
+  return executiveEventTimeoutQueue( e ) != NULL;
+}
+
+// From a worker, so with the tree's lock not to be taken again
+static void execActionMigrate( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  assert( executiveMigrate( executiveEventExecutive( e ), child,
+							onQueue, NULL ) == 10 );
+}
+
+/*
+  Timeout queue Events migrated, from within a batch, to a child, so
+  within the one locked tree.
+*/
+static void test4(void) {
+  Executive* e = executiveNew();
+  child = executiveNew();
+  assert( executiveAttachChild( e, child ) == 0 );
+  ExecutiveWorkers* w = executiveWorkersNew( 2, NULL );
+  assert( w );
+
+  struct timeval duration = { 60, 0 }, now = { 1000, 0 }, at = { 0, 0 };
+  ExecutiveTimeoutQueue* q = executiveTimeoutQueue( e, &duration );
+  for( int i = 0; i < 10; i++ )
+	assert( executiveTimeoutAdd( q, &now, NULL, NULL ) );
+  executiveAdd( e, &at, execActionMigrate );
+
+  assert( executiveFireParallel( e, &now, w ) == 1 );
+  assert( executiveTimeoutQueueLength( q ) == 0 );
+  q = executiveTimeoutQueue( child, &duration );
+  assert( executiveTimeoutQueueLength( q ) == 10 );
+
+  executiveWorkersFree( w );
+  executiveFree( child );
+  executiveFree( e );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  if(4)
+	test4();
+
+  return 0;
+}
+
+// eof
@@ -0,0 +1,114 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+#include "executive/loop.h"
+#include "executive/profile.h"
+
+/**
+ * Per-Action profiling: one Action burning CPU, one merely waiting.
+ * Not static, so that dladdr can name them.
+ */
+
+void profileTestsBurn( Event* e, struct timeval* actualTime ) {
+  (void)e;
+  (void)actualTime;
+  struct timespec start, now;
+  clock_gettime( CLOCK_THREAD_CPUTIME_ID, &start );
+  do {
+	clock_gettime( CLOCK_THREAD_CPUTIME_ID, &now );
+  } while( (now.tv_sec - start.tv_sec) * 1000000000L +
+		   (now.tv_nsec - start.tv_nsec) < 2000000 );
+}
+
+void profileTestsSleep( Event* e, struct timeval* actualTime ) {
+  (void)e;
+  (void)actualTime;
+  struct timespec ts = { 0, 2000000 };
+  nanosleep( &ts, NULL );
+}
+
+static void test1(void) {
+  Executive* e = executiveNew();
+  struct timeval tv = { 1000, 0 };
+  for( int i = 0; i < 5; i++ ) {
+	executiveAdd( e, &tv, profileTestsBurn );
+	executiveAdd( e, &tv, profileTestsSleep );
+  }
+
+  // not profiling, so no figures
+  ExecutiveProfileStats s;
+  assert( !executiveProfileGet( e, profileTestsBurn, &s ) );
+
+  assert( executiveProfileStart( e ) == 0 );
+  executiveRunSimulated( e, &tv );
+
+  assert( executiveProfileGet( e, profileTestsBurn, &s ) );
+  assert( s.calls == 5 );
+  assert( s.cpuTotal >= 5 * 2000000 );
+  assert( s.cpuMax >= 2000000 && s.wallMax >= 2000000 );
+
+  assert( executiveProfileGet( e, profileTestsSleep, &s ) );
+  assert( s.calls == 5 );
+  assert( s.wallTotal >= 5 * 2000000 );
+  assert( s.cpuTotal < s.wallTotal );
+
+  // the burner tops the report, by CPU
+  FILE* f = tmpfile();
+  executiveProfileReport( e, f, 1 );
+  rewind( f );
+  char header[128], line[256];
+  assert( fgets( header, sizeof( header ), f ) );
+  assert( fgets( line, sizeof( line ), f ) );
+  assert( strstr( line, "profileTestsBurn" ) );
+  assert( !fgets( line, sizeof( line ), f ) );
+  fclose( f );
+
+  executiveProfileStop( e );
+  assert( !executiveProfileGet( e, profileTestsBurn, &s ) );
+  executiveFree( e );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  return 0;
+}
+
+// eof
@@ -0,0 +1,204 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+
+#include "executive/loop.h"
+#include "executive/rate.h"
+
+/**
+ * Token bucket rate limiters, tried and queued for.
+ */
+
+// A burst of 3, then one token per 100ms
+static void test1(void) {
+  Executive* e = executiveNew();
+  struct timeval interval = { 0, 100000 };
+  assert( !executiveRateLimiterNew( e, &interval, 0 ) && errno == EINVAL );
+  ExecutiveRateLimiter* l = executiveRateLimiterNew( e, &interval, 3 );
+  assert( l );
+
+  struct timeval now = { 1000, 0 };
+  for( int i = 0; i < 3; i++ )
+	assert( executiveRateLimiterTryAcquire( l, &now ) );
+  assert( !executiveRateLimiterTryAcquire( l, &now ) );
+
+  now.tv_usec = 99999;
+  assert( !executiveRateLimiterTryAcquire( l, &now ) );
+  now.tv_usec = 100000;
+  assert( executiveRateLimiterTryAcquire( l, &now ) );
+  assert( !executiveRateLimiterTryAcquire( l, &now ) );
+
+  // idle a long while, the bucket refills, but only to 3
+  now.tv_sec = 2000;
+  for( int i = 0; i < 3; i++ )
+	assert( executiveRateLimiterTryAcquire( l, &now ) );
+  assert( !executiveRateLimiterTryAcquire( l, &now ) );
+
+  executiveRateLimiterFree( l );
+  executiveFree( e );
+}
+
+typedef struct Flow {
+  struct timeval granted[1000];
+  int count;
+  ExecutiveRateLimiter* limiter;
+} Flow;
+
+static void execActionGranted( Event* e, struct timeval* actualTime ) {
+  Flow* f = executiveEventEnv( e );
+  f->granted[f->count++] = *actualTime;
+  // however many queued, just the one Event
+  assert( executiveLength( executiveEventExecutive( e ) ) <= 1 );
+}
+
+/*
+  Pacing: a thousand waiters, burst 1, granted exactly 10ms apart, off
+  the one Event.
+*/
+static void test2(void) {
+  Executive* e = executiveNew();
+  struct timeval interval = { 0, 10000 };
+  Flow f = { .count = 0 };
+  f.limiter = executiveRateLimiterNew( e, &interval, 1 );
+
+  struct timeval now = { 1000, 0 };
+  for( int i = 0; i < 1000; i++ )
+	assert( executiveRateLimiterAcquireAsync( f.limiter, &now,
+											  execActionGranted, &f ) == 0 );
+  assert( executiveRateLimiterWaiting( f.limiter ) == 1000 );
+  assert( executiveLength( e ) == 1 );
+  assert( !executiveRateLimiterTryAcquire( f.limiter, &now ) );
+
+  struct timeval until = { 1004, 990000 };
+  executiveRunSimulated( e, &until );
+  assert( f.count == 500 );
+  assert( executiveRateLimiterWaiting( f.limiter ) == 500 );
+  for( int i = 0; i < 500; i++ ) {
+	long usec = (f.granted[i].tv_sec - 1000) * 1000000L + f.granted[i].tv_usec;
+	assert( usec == i * 10000L );
+  }
+
+  // waiters discarded, not called
+  executiveRateLimiterFree( f.limiter );
+  assert( executiveLength( e ) == 0 );
+  until.tv_sec = 2000;
+  executiveRunSimulated( e, &until );
+  assert( f.count == 500 );
+  executiveFree( e );
+}
+
+static void execActionFree( Event* e, struct timeval* actualTime ) {
+  execActionGranted( e, actualTime );
+  Flow* f = executiveEventEnv( e );
+  if( f->count == 3 )
+	executiveRateLimiterFree( f->limiter );
+}
+
+// Freed from within a waiter's Action
+static void test3(void) {
+  Executive* e = executiveNew();
+  struct timeval interval = { 1, 0 };
+  Flow f = { .count = 0 };
+  f.limiter = executiveRateLimiterNew( e, &interval, 2 );
+  struct timeval now = { 1000, 0 };
+  for( int i = 0; i < 10; i++ )
+	executiveRateLimiterAcquireAsync( f.limiter, &now, execActionFree, &f );
+  struct timeval until = { 2000, 0 };
+  executiveRunSimulated( e, &until );
+  assert( f.count == 3 );
+  executiveFree( e );
+}
+
+static int denied;
+
+static void execActionMaybe( Event* e, struct timeval* actualTime ) {
+  Flow* f = executiveEventEnv( e );
+  if( executiveRateLimiterDenied( f->limiter ) ) {
+	denied++;
+	struct timeval now = *actualTime;
+	assert( executiveRateLimiterAcquireAsync( f->limiter, &now,
+											  execActionMaybe, f ) == -1 );
+	return;
+  }
+  f->granted[f->count++] = *actualTime;
+}
+
+/*
+  The Executive full once the first token is granted, the limiter
+  cannot wait for the next, so denies the rest, at once.
+*/
+static void test4(void) {
+  Executive* e = executiveNew();
+  struct timeval interval = { 0, 100000 };
+  Flow f = { .count = 0 };
+  f.limiter = executiveRateLimiterNew( e, &interval, 1 );
+  struct timeval now = { 1000, 0 }, filler = { 2000, 0 };
+  for( int i = 0; i < 3; i++ )
+	assert( executiveRateLimiterAcquireAsync( f.limiter, &now,
+											  execActionMaybe, &f ) == 0 );
+  executiveAdd( e, &filler, NULL );
+  executiveSetLimits( e, 1, 0 );
+
+  denied = 0;
+  struct timeval until = { 1001, 0 };
+  executiveRunSimulated( e, &until );
+  assert( f.count == 1 && denied == 2 );
+  assert( executiveRateLimiterWaiting( f.limiter ) == 0 );
+  assert( !executiveRateLimiterDenied( f.limiter ) );
+  assert( executiveLength( e ) == 1 );
+
+  executiveRateLimiterFree( f.limiter );
+  executiveFree( e );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  if(4)
+	test4();
+
+  return 0;
+}
+
+// eof
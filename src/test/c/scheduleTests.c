@@ -0,0 +1,195 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "executive/loop.h"
+#include "executive/schedule.h"
+
+/**
+ * Cron-style schedules, their next occurrences and their firing.
+ */
+
+static void execActionNone( Event* e, struct timeval* actualTime ) {
+  (void)e;
+  (void)actualTime;
+}
+
+static long next( Executive* e, const char* spec, long after ) {
+  struct timeval tv = { after, 0 }, result;
+  ExecutiveSchedule* s = executiveAddSchedule( e, spec, &tv,
+											   execActionNone, NULL );
+  assert( s );
+  bool found = executiveScheduleNext( s, &tv, &result );
+  assert( found );
+  executiveScheduleCancel( s );
+  return result.tv_sec;
+}
+
+// Spec parsing, and next occurrences, all in UTC
+static void test1(void) {
+  Executive* e = executiveNew();
+
+  struct timeval now;
+  gettimeofday( &now, NULL );
+  const char* bad[] = { "", "* * * *", "60 * * * *", "* * 0 * *",
+						"*/0 * * * *", "5-1 * * * *", "* * * * * *",
+						"a * * * *", "@often" };
+  for( size_t i = 0; i < sizeof( bad ) / sizeof( bad[0] ); i++ ) {
+	errno = 0;
+	assert( !executiveAddSchedule( e, bad[i], &now, execActionNone, NULL ) );
+	assert( errno == EINVAL );
+  }
+
+  // Mon 1 Jan 2024 00:07:30
+  long t = 1704067650;
+  assert( next( e, "*/15 * * * *", t ) == 1704068100 );
+  assert( next( e, "0 2 * * *", t ) == 1704074400 );
+  assert( next( e, "30 9 * * 1-5", t ) == 1704101400 );
+  assert( next( e, "@daily", t ) == 1704067650 - 450 + 86400 );
+  // the 13th or a Friday, the first Friday coming first
+  assert( next( e, "0 0 13 * 5", t ) == 1704412800 );
+  // '*/2' counts as '*', so odd days that are Mondays: 15 Jan
+  assert( next( e, "0 0 */2 * 1", t ) == 1705276800 );
+  // and firsts of the month on Sun, Tue, Thu or Sat: Thu 1 Feb
+  assert( next( e, "0 0 1 * */2", t ) == 1706745600 );
+  // from 1 Mar 2024, the next 29 Feb is in 2028
+  assert( next( e, "0 0 29 2 *", 1709251200 ) == 1835395200 );
+  // never
+  assert( !executiveAddSchedule( e, "0 0 31 2 *", &now,
+								 execActionNone, NULL ) );
+
+  assert( executiveLength( e ) == 0 );
+  executiveFree( e );
+}
+
+static void execActionCount( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  int* ip = executiveEventEnv( e );
+  assert( executiveEventScheduledTime( e )->tv_sec % 900 == 0 );
+  (*ip)++;
+}
+
+static ExecutiveSchedule* cancelMe;
+
+static void execActionCancel( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  int* ip = executiveEventEnv( e );
+  if( ++(*ip) == 3 )
+	executiveScheduleCancel( cancelMe );
+}
+
+/*
+  A day of schedules, in virtual time, starting Mon 1 Jan 2024
+  00:07:30. Each has just the one Event pending, throughout.
+*/
+static void test2(void) {
+  Executive* e = executiveNew();
+
+  struct timeval now = { 1704067650, 0 }, day = { 86400, 0 }, until;
+  int quarters = 0, cancelled = 0;
+  ExecutiveSchedule* s = executiveAddSchedule( e, "*/15 * * * *", &now,
+											   execActionCount, &quarters );
+  assert( s );
+  cancelMe = executiveAddSchedule( e, "@hourly", &now, execActionCancel,
+								   &cancelled );
+  assert( cancelMe );
+  // left pending, free'd along with the Executive
+  assert( executiveAddSchedule( e, "0 0 1 1 *", &now, execActionNone, NULL ) );
+  assert( executiveLength( e ) == 3 );
+
+  timeradd( &now, &day, &until );
+  executiveRunSimulated( e, &until );
+  assert( quarters == 96 );
+  assert( cancelled == 3 );
+  assert( executiveLength( e ) == 2 );
+
+  executiveScheduleCancel( s );
+  assert( executiveLength( e ) == 1 );
+  executiveFree( e );
+}
+
+/*
+  Through DST changes, in US Eastern time: 02:30 on the spring-forward
+  day is 03:30, and 01:30 on the fall-back day happens just once.
+*/
+static void test3(void) {
+  Executive* e = executiveNew();
+  setenv( "TZ", "EST5EDT,M3.2.0,M11.1.0", 1 );
+  tzset();
+
+  // Sat 7 Mar 2026 12:00 EST, on to 8 Mar 03:30 EDT, 9 Mar 02:30 EDT
+  long t = next( e, "30 2 * * *", 1772902800 );
+  assert( t == 1772955000 );
+  assert( next( e, "30 2 * * *", t ) == 1773037800 );
+
+  // Sat 31 Oct 2026 12:00 EDT, on to 1 Nov 01:30, then 2 Nov 01:30 EST
+  t = next( e, "30 1 * * *", 1793462400 );
+  assert( t == 1793511000 || t == 1793514600 );
+  assert( next( e, "30 1 * * *", t ) == 1793601000 );
+
+  // quarter hours across it, always onwards, the repeat not re-run
+  t = 1793508600;
+  for( int i = 0; i < 16; i++ ) {
+	long n = next( e, "*/15 * * * *", t );
+	assert( n > t && n - t <= 900 + 3600 );
+	t = n;
+  }
+
+  setenv( "TZ", "UTC", 1 );
+  tzset();
+  executiveFree( e );
+}
+
+int main(void) {
+
+  setenv( "TZ", "UTC", 1 );
+  tzset();
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  return 0;
+}
+
+// eof
@@ -0,0 +1,238 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "executive/shared.h"
+
+/**
+ * An Executive in shared memory, used by two processes.
+ */
+
+enum { LEASE, OTHER };
+
+typedef struct Lease {
+  char name[16];
+  int id;
+} Lease;
+
+static char fired[256];
+
+static void execActionLease( Event* e, struct timeval* actualTime ) {
+  (void)actualTime;
+  Lease* l = executiveEventEnv( e );
+  assert( !executiveEventExecutive( e ) );
+  strcat( fired, l->name );
+  strcat( fired, "|" );
+}
+
+static void add( ExecutiveShared* s, long sec, const char* name,
+				 ExecutiveSharedId* id ) {
+  struct timeval tv = { sec, 0 };
+  Lease l = { .id = 0 };
+  strcpy( l.name, name );
+  *id = executiveSharedAdd( s, &tv, LEASE, &l, sizeof( l ) );
+  assert( *id );
+}
+
+// Time order, FIFO on ties, cancel, capacity, all in one process
+static void test1( const char* name ) {
+  ExecutiveShared* s = executiveSharedCreate( name, 4, sizeof( Lease ) );
+  assert( s );
+  assert( !executiveSharedCreate( name, 4, sizeof( Lease ) ) &&
+		  errno == EEXIST );
+  executiveSharedSetAction( s, LEASE, execActionLease );
+
+  ExecutiveSharedId a, b, c, d;
+  add( s, 30, "c", &c );
+  add( s, 10, "a", &a );
+  add( s, 20, "b", &b );
+  add( s, 20, "b2", &d );
+  struct timeval tv = { 1, 0 };
+  assert( !executiveSharedAdd( s, &tv, LEASE, NULL, 0 ) );
+  assert( !executiveSharedAdd( s, &tv, EXECUTIVE_SHARED_KINDS, NULL, 0 ) );
+
+  assert( executiveSharedCancel( s, b ) == 0 );
+  assert( executiveSharedCancel( s, b ) == -1 );
+  assert( executiveSharedLength( s ) == 3 );
+
+  // a second mapping, as another process would have
+  ExecutiveShared* t = executiveSharedOpen( name );
+  assert( t );
+  executiveSharedSetAction( t, LEASE, execActionLease );
+  fired[0] = 0;
+  assert( executiveSharedRunOnce( t, NULL ) == 3 );
+  assert( strcmp( fired, "a|b2|c|" ) == 0 );
+  assert( executiveSharedLength( s ) == 0 );
+
+  // stale ids, slots since reused, cancel nothing
+  add( s, 40, "e", &b );
+  assert( executiveSharedCancel( s, a ) == -1 );
+  assert( executiveSharedCancel( t, b ) == 0 );
+
+  executiveSharedClose( t );
+  executiveSharedClose( s );
+  assert( executiveSharedUnlink( name ) == 0 );
+  assert( !executiveSharedOpen( name ) );
+}
+
+/*
+  A child waits, with nothing to do. The parent adds an Event due
+  shortly, which must wake the child, who then fires it on time.
+*/
+static void test2( const char* name ) {
+  ExecutiveShared* s = executiveSharedCreate( name, 16, sizeof( Lease ) );
+  assert( s );
+  executiveSharedUnlink( name );
+
+  pid_t pid = fork();
+  assert( pid >= 0 );
+  if( pid == 0 ) {
+	executiveSharedSetAction( s, LEASE, execActionLease );
+	fired[0] = 0;
+	struct timeval timeout = { 5, 0 }, start, now;
+	gettimeofday( &start, NULL );
+	int n = 0;
+	while( n == 0 ) {
+	  n = executiveSharedRunOnce( s, &timeout );
+	  gettimeofday( &now, NULL );
+	  if( now.tv_sec - start.tv_sec > 4 )
+		_exit( 2 );
+	}
+	_exit( n == 1 && strcmp( fired, "lease|" ) == 0 ? 0 : 1 );
+  }
+
+  // let the child get to waiting
+  usleep( 100000 );
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  tv.tv_usec += 50000;
+  if( tv.tv_usec >= 1000000 ) {
+	tv.tv_sec++;
+	tv.tv_usec -= 1000000;
+  }
+  Lease l = { "lease", 1 };
+  assert( executiveSharedAdd( s, &tv, LEASE, &l, sizeof( l ) ) );
+
+  int status;
+  assert( waitpid( pid, &status, 0 ) == pid );
+  assert( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+  assert( executiveSharedLength( s ) == 0 );
+  executiveSharedClose( s );
+}
+
+static bool late;
+
+static void execActionOnTime( Event* e, struct timeval* actualTime ) {
+  struct timeval* t = executiveEventScheduledTime( e );
+  long lateness = (actualTime->tv_sec - t->tv_sec) * 1000000L +
+	actualTime->tv_usec - t->tv_usec;
+  if( lateness > 30000 )
+	late = true;
+}
+
+/*
+  Three children wait, in short stretches.  The parent adds Events,
+  each earlier than the last, so each waking just one child.  Some
+  child is waiting for each new head, so all are fired, once, on time.
+*/
+static void test3( const char* name ) {
+  ExecutiveShared* s = executiveSharedCreate( name, 16, sizeof( Lease ) );
+  assert( s );
+  executiveSharedUnlink( name );
+
+  pid_t pids[3];
+  for( int c = 0; c < 3; c++ ) {
+	pids[c] = fork();
+	assert( pids[c] >= 0 );
+	if( pids[c] == 0 ) {
+	  executiveSharedSetAction( s, LEASE, execActionOnTime );
+	  struct timeval timeout = { 0, 300000 }, start, now;
+	  gettimeofday( &start, NULL );
+	  int n = 0;
+	  do {
+		n += executiveSharedRunOnce( s, &timeout );
+		gettimeofday( &now, NULL );
+	  } while( now.tv_sec - start.tv_sec < 2 );
+	  _exit( late ? 100 : n );
+	}
+  }
+
+  // let the children get to waiting
+  usleep( 100000 );
+  struct timeval now;
+  gettimeofday( &now, NULL );
+  Lease l = { "lease", 1 };
+  for( int i = 3; i > 0; i-- ) {
+	struct timeval delta = { 0, i * 100000 }, tv;
+	timeradd( &now, &delta, &tv );
+	assert( executiveSharedAdd( s, &tv, LEASE, &l, sizeof( l ) ) );
+  }
+
+  int total = 0;
+  for( int c = 0; c < 3; c++ ) {
+	int status;
+	assert( waitpid( pids[c], &status, 0 ) == pids[c] );
+	assert( WIFEXITED( status ) && WEXITSTATUS( status ) != 100 );
+	total += WEXITSTATUS( status );
+  }
+  assert( total == 3 );
+  assert( executiveSharedLength( s ) == 0 );
+  executiveSharedClose( s );
+}
+
+int main(void) {
+
+  char name[64];
+  snprintf( name, sizeof( name ), "/executive-sharedTests-%d", (int)getpid() );
+
+  if(1)
+	test1( name );
+
+  if(2)
+	test2( name );
+
+  if(3)
+	test3( name );
+
+  return 0;
+}
+
+// eof
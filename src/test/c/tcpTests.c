@@ -0,0 +1,354 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "executive/loop.h"
+#include "executive/tcp.h"
+
+/**
+ * A listener and connections over loopback, both ends on one
+ * Executive.
+ */
+
+typedef struct Peer {
+  ExecutiveConnection* c;
+  char data[64];
+  size_t length;
+  size_t bytes;
+  int closes;
+  int error;
+  int writes;
+} Peer;
+
+static Peer server, client;
+
+static void peerRead( ExecutiveConnection* c, const char* data, size_t length,
+					  void* env ) {
+  Peer* p = env;
+  if( p->length + length <= sizeof( p->data ) )
+	memcpy( p->data + p->length, data, length );
+  p->length += length;
+  p->bytes += length;
+  (void)c;
+}
+
+static void peerWrite( ExecutiveConnection* c, void* env ) {
+  (void)c;
+  ((Peer*)env)->writes++;
+}
+
+static void peerClose( ExecutiveConnection* c, int error, void* env ) {
+  (void)c;
+  Peer* p = env;
+  p->closes++;
+  p->error = error;
+  p->c = NULL;
+}
+
+static void echoRead( ExecutiveConnection* c, const char* data, size_t length,
+					  void* env ) {
+  peerRead( c, data, length, env );
+  executiveConnectionWrite( c, data, length );
+}
+
+// The server Peer's read action, or a close from within it
+static ConnectionReadAction serverRead;
+
+static void acceptServer( ExecutiveListener* l, ExecutiveConnection* c,
+						  struct timeval* now, void* env ) {
+  (void)l;
+  (void)now;
+  (void)env;
+  server.c = c;
+  executiveConnectionSetActions( c, serverRead, peerWrite, peerClose,
+								 &server );
+}
+
+static void closeRead( ExecutiveConnection* c, const char* data,
+					   size_t length, void* env ) {
+  peerRead( c, data, length, env );
+  executiveConnectionClose( c );
+  ((Peer*)env)->c = NULL;
+}
+
+// Blocking connect to the listener, then a client Peer on that socket
+static void connectClient( Executive* e, ExecutiveListener* l ) {
+  int fd = socket( AF_INET, SOCK_STREAM, 0 );
+  assert( fd >= 0 );
+  struct sockaddr_in sin = { .sin_family = AF_INET,
+							 .sin_port = htons( executiveListenerPort( l ) ) };
+  sin.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  int sc = connect( fd, (struct sockaddr*)&sin, sizeof( sin ) );
+  assert( sc == 0 );
+  struct timeval now;
+  gettimeofday( &now, NULL );
+  client.c = executiveConnectionNew( e, fd, NULL, &now );
+  assert( client.c );
+  executiveConnectionSetActions( client.c, peerRead, peerWrite, peerClose,
+								 &client );
+}
+
+// Run until 'done', each loop iteration at most 10ms, for at most 5s
+static void runUntil( Executive* e, bool (*done)(void) ) {
+  struct timeval now, until, tick;
+  struct timeval step = { 0, 10000 }, limit = { 5, 0 };
+  gettimeofday( &now, NULL );
+  timeradd( &now, &limit, &until );
+  while( !done() && timercmp( &now, &until, < ) ) {
+	timeradd( &now, &step, &tick );
+	executiveAdd( e, &tick, NULL );
+	assert( executiveRunOnce( e ) >= 0 );
+	gettimeofday( &now, NULL );
+  }
+  assert( done() );
+  executiveClearMatchingAction( e, NULL );
+}
+
+static void reset(void) {
+  memset( &server, 0, sizeof( server ) );
+  memset( &client, 0, sizeof( client ) );
+  serverRead = echoRead;
+}
+
+static bool accepted(void) { return server.c; }
+static bool echoed(void) { return client.length == 4; }
+static bool serverClosed(void) { return server.closes; }
+static bool clientClosed(void) { return client.closes; }
+
+// Accept, echo, then the client closes, the server seeing eof
+static void test1(void) {
+  reset();
+  Executive* e = executiveNew();
+  ExecutiveListener* l = executiveListenerNew( e, "127.0.0.1", 0, 0,
+											   acceptServer, NULL );
+  assert( l );
+  assert( executiveListenerPort( l ) > 0 );
+
+  connectClient( e, l );
+  runUntil( e, accepted );
+  assert( executiveListenerAccepted( l ) == 1 );
+
+  assert( executiveConnectionWrite( client.c, "ping", 4 ) == 0 );
+  runUntil( e, echoed );
+  assert( memcmp( client.data, "ping", 4 ) == 0 );
+  assert( server.length == 4 );
+
+  executiveConnectionClose( client.c );
+  runUntil( e, serverClosed );
+  assert( server.error == 0 );
+  assert( client.closes == 0 );
+
+  executiveListenerFree( l );
+  assert( executiveRunOnce( e ) == 0 );
+  executiveFree( e );
+}
+
+/*
+  A silent connection is closed at its idle timeout, an active one
+  not. Either way, no timeout remains once a connection is closed.
+*/
+static void test2(void) {
+  reset();
+  Executive* e = executiveNew();
+  ExecutiveListener* l = executiveListenerNew( e, "127.0.0.1", 0, 0,
+											   acceptServer, NULL );
+  struct timeval idle = { 0, 200000 };
+  assert( executiveListenerSetIdle( l, &idle ) == 0 );
+
+  connectClient( e, l );
+  runUntil( e, accepted );
+  assert( executiveLength( e ) == 1 );
+
+  // activity re-arms the timeout
+  for( int i = 0; i < 4; i++ ) {
+	usleep( 100000 );
+	executiveConnectionWrite( client.c, "ping", 4 );
+	client.length = 0;
+	runUntil( e, echoed );
+  }
+  assert( server.closes == 0 );
+
+  runUntil( e, serverClosed );
+  assert( server.error == ETIMEDOUT );
+  assert( executiveLength( e ) == 0 );
+  runUntil( e, clientClosed );
+  assert( client.error == 0 );
+
+  // closed by the server from within its read action, so cancelled
+  reset();
+  serverRead = closeRead;
+  connectClient( e, l );
+  runUntil( e, accepted );
+  assert( executiveLength( e ) == 1 );
+  executiveConnectionWrite( client.c, "ping", 4 );
+  runUntil( e, clientClosed );
+  assert( server.length == 4 );
+  assert( server.closes == 0 );
+  assert( executiveLength( e ) == 0 );
+
+  executiveListenerFree( l );
+  executiveFree( e );
+}
+
+static ExecutiveListener* shards[2];
+static int shardAccepts[2];
+
+static void acceptShard( ExecutiveListener* l, ExecutiveConnection* c,
+						 struct timeval* now, void* env ) {
+  (void)l;
+  (void)now;
+  shardAccepts[(int)(intptr_t)env]++;
+  executiveConnectionClose( c );
+}
+
+static bool allAccepted(void) {
+  return shardAccepts[0] + shardAccepts[1] == 32;
+}
+
+// Two listeners on one port, one per 'shard', sharing its connections
+static void test3(void) {
+  Executive* e[2] = { executiveNew(), executiveNew() };
+  shards[0] = executiveListenerNew( e[0], "127.0.0.1", 0,
+									EXECUTIVE_LISTEN_REUSEPORT,
+									acceptShard, (void*)0 );
+  assert( shards[0] );
+  unsigned short port = executiveListenerPort( shards[0] );
+
+  // not without the flag
+  assert( !executiveListenerNew( e[1], "127.0.0.1", port, 0,
+								 acceptShard, (void*)1 ) );
+  assert( errno == EADDRINUSE );
+  shards[1] = executiveListenerNew( e[1], "127.0.0.1", port,
+									EXECUTIVE_LISTEN_REUSEPORT,
+									acceptShard, (void*)1 );
+  assert( shards[1] );
+  assert( executiveListenerPort( shards[1] ) == port );
+
+  int fds[32];
+  for( int i = 0; i < 32; i++ ) {
+	fds[i] = socket( AF_INET, SOCK_STREAM, 0 );
+	struct sockaddr_in sin = { .sin_family = AF_INET,
+							   .sin_port = htons( port ) };
+	sin.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	int sc = connect( fds[i], (struct sockaddr*)&sin, sizeof( sin ) );
+	assert( sc == 0 );
+  }
+
+  // each shard's loop run in turn, as its own thread would
+  for( int i = 0; i < 100 && !allAccepted(); i++ ) {
+	for( int s = 0; s < 2; s++ ) {
+	  struct timeval tick;
+	  gettimeofday( &tick, NULL );
+	  tick.tv_usec = tick.tv_usec < 999000 ? tick.tv_usec + 1000 : 999999;
+	  executiveAdd( e[s], &tick, NULL );
+	  assert( executiveRunOnce( e[s] ) >= 0 );
+	}
+  }
+  assert( allAccepted() );
+  // both shards had a share, barring a most unlikely hash
+  assert( shardAccepts[0] && shardAccepts[1] );
+  assert( executiveListenerAccepted( shards[0] ) +
+		  executiveListenerAccepted( shards[1] ) == 32 );
+
+  for( int i = 0; i < 32; i++ )
+	close( fds[i] );
+  for( int s = 0; s < 2; s++ ) {
+	executiveListenerFree( shards[s] );
+	executiveFree( e[s] );
+  }
+}
+
+static char big[16 << 20];
+
+static bool drained(void) {
+  return server.writes && client.bytes == sizeof( big );
+}
+
+// Output backs up, the write action says when it is all written
+static void test4(void) {
+  reset();
+  Executive* e = executiveNew();
+  ExecutiveListener* l = executiveListenerNew( e, "127.0.0.1", 0, 0,
+											   acceptServer, NULL );
+  connectClient( e, l );
+  runUntil( e, accepted );
+
+  memset( big, 'x', sizeof( big ) );
+  ExecutiveOutput* out = executiveConnectionOutput( server.c );
+  assert( executiveOutputWriteRef( out, big, sizeof( big ), NULL, NULL ) == 0 );
+  assert( executiveOutputFlush( out ) > 0 );
+  assert( server.writes == 0 );
+
+  runUntil( e, drained );
+  assert( server.writes == 1 );
+  assert( executiveOutputPending( out ) == 0 );
+
+  executiveConnectionClose( server.c );
+  runUntil( e, clientClosed );
+  executiveListenerFree( l );
+  executiveFree( e );
+}
+
+int main(void) {
+
+  signal( SIGPIPE, SIG_IGN );
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  if(4)
+	test4();
+
+  return 0;
+}
+
+// eof
@@ -0,0 +1,138 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <assert.h>
+#include <time.h>
+
+#include "executive/watchdog.h"
+
+/**
+ * An Action overrunning its budget is reported, just once, with a
+ * stack sample.  One within budget is not.
+ */
+
+static int overruns = 0;
+static ExecutiveOverrun last;
+
+static void overrunRecord( ExecutiveOverrun* o, void* arg ) {
+  (void)arg;
+  last = *o;
+  overruns++;
+}
+
+// Busy, not sleeping, so no system call to interrupt
+static void spin( long ms ) {
+  struct timespec start, now;
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  do {
+	clock_gettime( CLOCK_MONOTONIC, &now );
+  } while( (now.tv_sec - start.tv_sec) * 1000 +
+		   (now.tv_nsec - start.tv_nsec) / 1000000 < ms );
+}
+
+static void execActionSlow( Event* e, struct timeval* actualTime ) {
+  (void)e;
+  (void)actualTime;
+  spin( 200 );
+}
+
+static void execActionQuick( Event* e, struct timeval* actualTime ) {
+  (void)e;
+  (void)actualTime;
+  spin( 2 );
+}
+
+static void test1(void) {
+  Executive* e = executiveNew();
+  struct timeval budget = { 0, 40000 };
+  ExecutiveWatchdog* w = executiveWatchdogNew( e, &budget,
+											   overrunRecord, NULL );
+  assert( w );
+  assert( !executiveWatchdogNew( e, &budget, overrunRecord, NULL ) );
+
+  struct timeval quick = { 10, 0 }, slow = { 20, 0 }, now = { 30, 0 };
+  for( int i = 0; i < 5; i++ )
+	executiveAdd( e, &quick, execActionQuick );
+  executiveAdd( e, &slow, execActionSlow );
+  for( int i = 0; i < 5; i++ )
+	executiveFire( e, &now );
+  assert( overruns == 0 );
+
+  executiveFire( e, &now );
+  assert( overruns == 1 );
+  assert( last.executive == e );
+  assert( last.action == execActionSlow );
+  assert( last.scheduledTime.tv_sec == 20 );
+  assert( last.elapsed.tv_sec > 0 || last.elapsed.tv_usec >= 40000 );
+  assert( last.stackDepth > 2 );
+
+  // freed along with the Executive
+  executiveFree( e );
+}
+
+static volatile sig_atomic_t urgents = 0;
+
+static void urgentHandler( int signo ) {
+  (void)signo;
+  urgents++;
+}
+
+// A signal not the watchdog's still reaches the handler it displaced
+static void test2(void) {
+  Executive* e = executiveNew();
+  struct timeval budget = { 0, 40000 };
+  ExecutiveWatchdog* w = executiveWatchdogNew( e, &budget,
+											   overrunRecord, NULL );
+  assert( w );
+  urgents = 0;
+  raise( EXECUTIVE_WATCHDOG_SIGNAL );
+  assert( urgents == 1 );
+  executiveFree( e );
+}
+
+int main(void) {
+
+  // before any watchdog, so kept by the first, for test2
+  signal( EXECUTIVE_WATCHDOG_SIGNAL, urgentHandler );
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  return 0;
+}
+
+// eof
@@ -0,0 +1,139 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <cassert>
+#include <cstddef>
+#include <unistd.h>
+
+#include "executive/executive.hpp"
+
+/**
+ * Coroutines sleeping on, and awaiting fds via, an Executive (C++20).
+ */
+
+using namespace std::chrono;
+
+static executive::Task sleeper( executive::Executive& E, int& steps ) {
+  steps = 1;
+  co_await E.until( executive::TimePoint( seconds( 100 ) ) );
+  steps = 2;
+  co_await E.until( executive::TimePoint( seconds( 200 ) ) );
+  steps = 3;
+}
+
+static void test1(void) {
+  executive::Executive E;
+  int steps = 0;
+  sleeper( E, steps );
+  assert( steps == 1 );
+  assert( E.length() == 1 );
+  E.fire( executive::TimePoint( seconds( 100 ) ) );
+  assert( steps == 2 );
+  E.fire( executive::TimePoint( seconds( 200 ) ) );
+  assert( steps == 3 );
+  assert( E.length() == 0 );
+}
+
+static executive::Task reader( executive::Executive& E, int fd, char& c ) {
+  bool ok = co_await E.readable( fd );
+  assert( ok );
+  int nin = read( fd, &c, 1 );
+  assert( nin == 1 );
+  E.stop();
+}
+
+static executive::Task writer( executive::Executive& E, int fd ) {
+  co_await E.sleepFor( milliseconds( 10 ) );
+  int nout = write( fd, "y", 1 );
+  assert( nout == 1 );
+}
+
+static void test2(void) {
+  executive::Executive E;
+  int fds[2];
+  int sc = pipe( fds );
+  assert( sc == 0 );
+
+  char c = 0;
+  reader( E, fds[0], c );
+  writer( E, fds[1] );
+  sc = E.run();
+  assert( sc == 0 );
+  assert( c == 'y' );
+
+  close( fds[0] );
+  close( fds[1] );
+}
+
+static executive::Task napper( executive::Executive& E, bool& slept,
+							   bool& done ) {
+  slept = co_await E.until( executive::TimePoint( seconds( 100 ) ) );
+  done = true;
+}
+
+/*
+  A static Executive at capacity, and limited to it (caller storage
+  needing no slot), so the await cannot add its Event: the coroutine
+  carries on at once, told so, and completes.
+*/
+static void test3(void) {
+  alignas( std::max_align_t ) static unsigned char storage[4096];
+  assert( executiveStaticSize( 2 ) <= sizeof( storage ) );
+  executive::Executive E( executiveInitStatic( storage, 2 ) );
+  executiveSetLimits( E.get(), 2, 0 );
+  E.add( executive::TimePoint( seconds( 10 ) ), [] {} );
+  E.add( executive::TimePoint( seconds( 20 ) ), [] {} );
+
+  bool slept = true, done = false;
+  napper( E, slept, done );
+  assert( done );
+  assert( !slept );
+  assert( E.length() == 2 );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  return 0;
+}
+
+// eof
@@ -0,0 +1,154 @@
+/**
+ * Copyright © 2023 Stuart Maclean
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER NOR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+ * TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+#include <cassert>
+#include <memory>
+
+#include "executive/executive.hpp"
+
+/**
+ * Exercise the C++ wrapper: small and large callables, their
+ * destruction on fire and on clear.
+ */
+
+using namespace std::chrono;
+
+using executive::TimePoint;
+
+// Counts live instances, so we can check destructors are run
+struct Counted {
+  static int live;
+  Counted() { live++; }
+  Counted( const Counted& ) noexcept { live++; }
+  ~Counted() { live--; }
+};
+int Counted::live = 0;
+
+static void test1(void) {
+  executive::Executive E;
+  TimePoint t0 = TimePoint( seconds( 100 ) );
+
+  int fired = 0;
+  E.add( t0 + seconds( 2 ), [&fired]() { fired = 2; } );
+  E.add( t0 + seconds( 1 ), [&fired]( TimePoint actual ) {
+	assert( actual == TimePoint( seconds( 200 ) ) );
+	fired = 1;
+  } );
+  assert( E.length() == 2 );
+  assert( E.peek() == t0 + seconds( 1 ) );
+
+  E.fire( TimePoint( seconds( 200 ) ) );
+  assert( fired == 1 );
+  E.fire( TimePoint( seconds( 200 ) ) );
+  assert( fired == 2 );
+  assert( E.length() == 0 );
+}
+
+// Too big to be inline, so boxed
+static void test2(void) {
+  executive::Executive E;
+  TimePoint t0 = TimePoint( seconds( 100 ) );
+
+  char big[EXECUTIVE_INLINE_ENV_SIZE * 2] = { 7 };
+  int fired = 0;
+  E.add( t0, [big, &fired]( TimePoint scheduled, TimePoint actual ) {
+	(void)actual;
+	assert( scheduled == TimePoint( seconds( 100 ) ) );
+	fired = big[0];
+  } );
+  E.fire( t0 );
+  assert( fired == 7 );
+}
+
+// Destructors run on fire, on clear and when the Executive goes
+static void test3(void) {
+  {
+	executive::Executive E;
+	TimePoint t0 = TimePoint( seconds( 100 ) );
+	Counted c;
+	char big[EXECUTIVE_INLINE_ENV_SIZE * 2] = { 0 };
+	E.add( t0, [c]() {} );
+	E.add( t0, [c, big]() { (void)big; } );
+	E.add( t0, [p = std::make_unique<Counted>()]() {} );
+	assert( Counted::live == 4 );
+	E.fire( t0 );
+	assert( Counted::live == 3 );
+	assert( E.clear() == 2 );
+	assert( Counted::live == 1 );
+	E.add( t0, [c]() {} );
+	assert( Counted::live == 2 );
+  }
+  assert( Counted::live == 0 );
+}
+
+// Throws on copy, so can only be boxed
+struct Throwing {
+  Throwing() = default;
+  Throwing( const Throwing& ) { throw 42; }
+  void operator()() const {}
+};
+
+// A callable failing to copy leaves no Event behind
+static void test4(void) {
+  executive::Executive E;
+  TimePoint t0 = TimePoint( seconds( 100 ) );
+  Throwing t;
+  bool thrown = false;
+  try {
+	E.add( t0, t );
+  } catch( int ) {
+	thrown = true;
+  }
+  assert( thrown );
+  assert( E.length() == 0 );
+}
+
+int main(void) {
+
+  if(1)
+	test1();
+
+  if(2)
+	test2();
+
+  if(3)
+	test3();
+
+  if(4)
+	test4();
+
+  return 0;
+}
+
+// eof